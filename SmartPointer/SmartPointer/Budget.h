@@ -0,0 +1,276 @@
+#pragma once
+
+#include "CacheLine.h"
+#include "UniquePtr.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+
+const size_t c_budgetStripesCount = 16;
+const size_t c_budgetStripeSlack = 4 * 1024;
+
+// Memory budget of a subsystem. Objects created with MakeBudgeted charge their size against
+// the budget and refund it when they are destroyed.
+//
+// The soft limit handler is called whenever a charge crosses the soft limit, so that the owner
+// can start shedding load. A charge that would exceed the hard limit calls the hard limit
+// handler and is retried once, if it still does not fit it is refused.
+//
+// Below the soft limit every thread charges from a slack reserved for its stripe and refunds
+// into it, so the shared counter is only written once per few kilobytes. The slack never
+// reaches past the soft limit and is handed back before a charge crosses it, above the soft
+// limit every charge is reserved exactly. The shared counter is only ever raised with a
+// compare-exchange that stays within the hard limit, so no charge sees bytes that are about
+// to be refused.
+class Budget
+{
+public:
+   using LimitHandler = std::function<void(Budget&)>;
+
+   Budget(const char* i_name, size_t i_softLimit, size_t i_hardLimit,
+      LimitHandler i_softLimitHandler = nullptr, LimitHandler i_hardLimitHandler = nullptr) :
+      m_name(i_name),
+      m_softLimit(i_softLimit),
+      m_hardLimit(i_hardLimit),
+      m_softLimitHandler(std::move(i_softLimitHandler)),
+      m_hardLimitHandler(std::move(i_hardLimitHandler))
+   {
+      m_reserved.m_value.store(0, std::memory_order_relaxed);
+      for (auto& slack : m_slack)
+      {
+         slack.m_value.store(0, std::memory_order_relaxed);
+      }
+   }
+
+   bool charge(size_t i_bytes)
+   {
+      if (!tryCharge(i_bytes))
+      {
+         if (!m_hardLimitHandler)
+         {
+            return false;
+         }
+
+         m_hardLimitHandler(*this);
+         if (!tryCharge(i_bytes))
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   void refund(size_t i_bytes)
+   {
+      if (m_reserved.m_value.load(std::memory_order_relaxed) > m_softLimit)
+      {
+         m_reserved.m_value.fetch_sub(i_bytes, std::memory_order_relaxed);
+         return;
+      }
+
+      std::atomic<size_t>& slack = m_slack[Stripe()].m_value;
+      size_t available = slack.fetch_add(i_bytes, std::memory_order_relaxed) + i_bytes;
+      while (available > 2 * c_budgetStripeSlack)
+      {
+         if (slack.compare_exchange_weak(available, c_budgetStripeSlack, std::memory_order_relaxed))
+         {
+            m_reserved.m_value.fetch_sub(available - c_budgetStripeSlack, std::memory_order_relaxed);
+            break;
+         }
+      }
+   }
+
+   const char* name() const
+   {
+      return m_name;
+   }
+
+   // Bytes charged and not refunded. It is exact while no charge or refund is in progress.
+   size_t used() const
+   {
+      size_t slack = 0;
+      for (const auto& stripeSlack : m_slack)
+      {
+         slack += stripeSlack.m_value.load(std::memory_order_relaxed);
+      }
+      const size_t reserved = m_reserved.m_value.load(std::memory_order_relaxed);
+      return reserved > slack ? reserved - slack : 0;
+   }
+
+   size_t softLimit() const
+   {
+      return m_softLimit;
+   }
+
+   size_t hardLimit() const
+   {
+      return m_hardLimit;
+   }
+
+   Budget(const Budget&) = delete;
+   Budget& operator = (const Budget&) = delete;
+
+private:
+   static size_t Stripe()
+   {
+      static SMART_POINTER_THREAD_LOCAL size_t stripe = 0;
+      if (!stripe)
+      {
+         const uint64_t hash = std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9e3779b97f4a7c15ull;
+         stripe = static_cast<size_t>(hash >> 60) + 1;
+      }
+      return stripe - 1;
+   }
+
+   bool tryCharge(size_t i_bytes)
+   {
+      std::atomic<size_t>& slack = m_slack[Stripe()].m_value;
+      size_t available = slack.load(std::memory_order_relaxed);
+      while (available >= i_bytes)
+      {
+         if (slack.compare_exchange_weak(available, available - i_bytes, std::memory_order_relaxed))
+         {
+            return true;
+         }
+      }
+
+      if (reserve(i_bytes, slack))
+      {
+         return true;
+      }
+      // Slack held by other stripes may be all that stands in the way.
+      returnSlack();
+      return reserve(i_bytes, slack);
+   }
+
+   bool reserve(size_t i_bytes, std::atomic<size_t>& o_slack)
+   {
+      size_t previous = m_reserved.m_value.load(std::memory_order_relaxed);
+      size_t reserved;
+      size_t extra;
+      bool slackReturned = false;
+      for (;;)
+      {
+         reserved = previous + i_bytes;
+         if (reserved > m_hardLimit || reserved < previous)
+         {
+            return false;
+         }
+
+         extra = reserved <= m_softLimit ? std::min(c_budgetStripeSlack, m_softLimit - reserved) : 0;
+         if (reserved > m_softLimit && previous <= m_softLimit && !slackReturned)
+         {
+            // The slack is handed back first, so that only charged bytes cross the soft limit.
+            returnSlack();
+            slackReturned = true;
+            previous = m_reserved.m_value.load(std::memory_order_relaxed);
+         }
+         else if (m_reserved.m_value.compare_exchange_weak(previous, reserved + extra, std::memory_order_relaxed))
+         {
+            break;
+         }
+      }
+
+      if (extra)
+      {
+         o_slack.fetch_add(extra, std::memory_order_relaxed);
+      }
+      if (reserved > m_softLimit && previous <= m_softLimit && m_softLimitHandler)
+      {
+         m_softLimitHandler(*this);
+      }
+      return true;
+   }
+
+   void returnSlack()
+   {
+      for (auto& slack : m_slack)
+      {
+         const size_t available = slack.m_value.exchange(0, std::memory_order_relaxed);
+         if (available)
+         {
+            m_reserved.m_value.fetch_sub(available, std::memory_order_relaxed);
+         }
+      }
+   }
+
+   const char* m_name;
+   const size_t m_softLimit;
+   const size_t m_hardLimit;
+   const LimitHandler m_softLimitHandler;
+   const LimitHandler m_hardLimitHandler;
+   CacheLinePadded<std::atomic<size_t>> m_reserved;
+   CacheLinePadded<std::atomic<size_t>> m_slack[c_budgetStripesCount];
+};
+
+template<class T>
+struct BudgetedDeleter;
+
+template <class T>
+using BudgetedUniquePtr = UniquePtr<T, BudgetedDeleter<T>>;
+
+template <class T, class... TParams>
+BudgetedUniquePtr<T> MakeBudgeted(Budget& i_budget, TParams&&... i_params);
+
+// Refunds the size of T to the budget the object was charged against. Only MakeBudgeted
+// attaches a budget, so a BudgetedUniquePtr created any other way holds none and deletes its
+// object without a refund.
+//
+// reset() and release() keep the deleter, so a BudgetedUniquePtr holding a budget must only
+// be reset with objects charged against that budget, such as one released from another
+// BudgetedUniquePtr of the same budget. An object that was never charged would be refunded
+// when it is destroyed. To replace the object, assign the result of MakeBudgeted instead.
+template<class T>
+struct BudgetedDeleter
+{
+   BudgetedDeleter() : m_budget(nullptr)
+   {
+   }
+
+   void operator()(T* i_ptr) const
+   {
+      delete i_ptr;
+      if (m_budget)
+      {
+         m_budget->refund(sizeof(T));
+      }
+   }
+
+private:
+   explicit BudgetedDeleter(Budget* i_budget) : m_budget(i_budget)
+   {
+   }
+
+   template <class TObject, class... TParams>
+   friend BudgetedUniquePtr<TObject> MakeBudgeted(Budget& i_budget, TParams&&... i_params);
+
+   Budget* m_budget;
+};
+
+// Throws std::bad_alloc when the budget can not afford another T.
+template <class T, class... TParams>
+BudgetedUniquePtr<T> MakeBudgeted(Budget& i_budget, TParams&&... i_params)
+{
+   static_assert(!std::is_array<T>::value, "MakeBudgeted does not support arrays.");
+
+   if (!i_budget.charge(sizeof(T)))
+   {
+      throw std::bad_alloc();
+   }
+
+   T* object = nullptr;
+   try
+   {
+      object = new T(std::forward<TParams>(i_params)...);
+   }
+   catch (...)
+   {
+      i_budget.refund(sizeof(T));
+      throw;
+   }
+   return BudgetedUniquePtr<T>(object, BudgetedDeleter<T>(&i_budget));
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+// Per-thread variables for the headers of this library, v120 has no thread_local and only
+// supports __declspec(thread) for variables initialized with a constant.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define SMART_POINTER_THREAD_LOCAL __declspec(thread)
+#else
+#define SMART_POINTER_THREAD_LOCAL thread_local
+#endif
+
+const size_t c_cacheLineSize = 64;
+
+// Pads a value to a whole cache line, so that values written by different threads are never
+// placed on the same line.
+template <class TAtomic>
+struct CacheLinePadded
+{
+   TAtomic m_value;
+   char m_padding[c_cacheLineSize - sizeof(TAtomic) % c_cacheLineSize];
+};
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "CacheLine.h"
+#include "UniquePtr.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+// Bounded lock-free channels passing UniquePtr ownership between threads.
+//
+// Only the stored pointer and deleter are kept in the ring, items left in a channel are
+// destroyed with their own deleter when the channel is destroyed. A push into a full channel
+// fails and leaves the item with the caller, a pop from an empty channel returns null.
+
+inline size_t ChannelCapacity(size_t i_requested)
+{
+   size_t capacity = 2;
+   while (capacity < i_requested)
+   {
+      if (capacity > static_cast<size_t>(-1) / 2)
+      {
+         throw std::length_error("Channel capacity does not fit into size_t.");
+      }
+      capacity *= 2;
+   }
+   return capacity;
+}
+
+// Items are moved in and out of the slots like between any two UniquePtrs, so ownership stays
+// within the UniquePtr family and checked mode keeps tracking objects passing a channel.
+template <class T, class D>
+struct ChannelSlot
+{
+   void store(UniquePtr<T, D>& i_uniquePtr)
+   {
+      m_item = std::move(i_uniquePtr);
+   }
+
+   UniquePtr<T, D> take()
+   {
+      return std::move(m_item);
+   }
+
+   UniquePtr<T, D> m_item;
+};
+
+// Single producer, single consumer channel.
+template <class T, class D = DefaultDeleter<T>>
+class SpscChannel
+{
+public:
+   static_assert(!std::is_array<T>::value && !std::is_reference<D>::value, "SpscChannel supports only non-array UniquePtr with deleters held by value.");
+
+   explicit SpscChannel(size_t i_capacity) :
+      m_mask(ChannelCapacity(i_capacity) - 1),
+      m_slots(MakeUnique<ChannelSlot<T, D>[]>(m_mask + 1))
+   {
+      m_head.m_value = 0;
+      m_tail.m_value = 0;
+      m_producerHead = 0;
+      m_consumerTail = 0;
+   }
+
+   ~SpscChannel()
+   {
+      while (tryPop())
+      {
+      }
+   }
+
+   size_t capacity() const
+   {
+      return m_mask + 1;
+   }
+
+   bool push(UniquePtr<T, D>&& i_item)
+   {
+      return pushBatch(&i_item, 1) == 1;
+   }
+
+   UniquePtr<T, D> tryPop()
+   {
+      UniquePtr<T, D> item;
+      popBatch(&item, 1);
+      return item;
+   }
+
+   // Pushes items from the front of i_items while there is room, publishing them with a
+   // single atomic store. Returns the number of items that were pushed.
+   size_t pushBatch(UniquePtr<T, D>* i_items, size_t i_count)
+   {
+      const size_t tail = m_tail.m_value.load(std::memory_order_relaxed);
+      if (capacity() - (tail - m_producerHead) < i_count)
+      {
+         m_producerHead = m_head.m_value.load(std::memory_order_acquire);
+      }
+
+      const size_t count = std::min(i_count, capacity() - (tail - m_producerHead));
+      for (size_t i = 0; i < count; ++i)
+      {
+         m_slots[(tail + i) & m_mask].store(i_items[i]);
+      }
+      m_tail.m_value.store(tail + count, std::memory_order_release);
+      return count;
+   }
+
+   // Pops up to i_maxCount items into o_items. Returns the number of items that were popped.
+   size_t popBatch(UniquePtr<T, D>* o_items, size_t i_maxCount)
+   {
+      const size_t head = m_head.m_value.load(std::memory_order_relaxed);
+      if (m_consumerTail - head < i_maxCount)
+      {
+         m_consumerTail = m_tail.m_value.load(std::memory_order_acquire);
+      }
+
+      const size_t count = std::min(i_maxCount, m_consumerTail - head);
+      for (size_t i = 0; i < count; ++i)
+      {
+         o_items[i] = m_slots[(head + i) & m_mask].take();
+      }
+      m_head.m_value.store(head + count, std::memory_order_release);
+      return count;
+   }
+
+   SpscChannel(const SpscChannel&) = delete;
+   SpscChannel& operator = (const SpscChannel&) = delete;
+
+private:
+   const size_t m_mask;
+   UniquePtr<ChannelSlot<T, D>[]> m_slots;
+   char m_padding[c_cacheLineSize];
+
+   // Written by the consumer.
+   CacheLinePadded<std::atomic<size_t>> m_head;
+   size_t m_consumerTail;
+   char m_consumerPadding[c_cacheLineSize];
+
+   // Written by the producer.
+   CacheLinePadded<std::atomic<size_t>> m_tail;
+   size_t m_producerHead;
+   char m_producerPadding[c_cacheLineSize];
+};
+
+// Multiple producer, single consumer channel. Every slot carries a sequence number telling
+// whether it is free for the producer claiming its position or ready for the consumer.
+template <class T, class D = DefaultDeleter<T>>
+class MpscChannel
+{
+public:
+   static_assert(!std::is_array<T>::value && !std::is_reference<D>::value, "MpscChannel supports only non-array UniquePtr with deleters held by value.");
+
+   explicit MpscChannel(size_t i_capacity) :
+      m_mask(ChannelCapacity(i_capacity) - 1),
+      m_slots(MakeUnique<Slot[]>(m_mask + 1))
+   {
+      for (size_t i = 0; i <= m_mask; ++i)
+      {
+         m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+      }
+      m_tail.m_value.store(0, std::memory_order_relaxed);
+      m_head = 0;
+   }
+
+   ~MpscChannel()
+   {
+      while (tryPop())
+      {
+      }
+   }
+
+   size_t capacity() const
+   {
+      return m_mask + 1;
+   }
+
+   bool push(UniquePtr<T, D>&& i_item)
+   {
+      return pushBatch(&i_item, 1) == 1;
+   }
+
+   UniquePtr<T, D> tryPop()
+   {
+      UniquePtr<T, D> item;
+      popBatch(&item, 1);
+      return item;
+   }
+
+   // Claims room for as many items from the front of i_items as possible with a single
+   // compare-exchange. Returns the number of items that were pushed.
+   size_t pushBatch(UniquePtr<T, D>* i_items, size_t i_count)
+   {
+      const size_t requested = std::min(i_count, capacity());
+      size_t tail = m_tail.m_value.load(std::memory_order_relaxed);
+      size_t count = 0;
+      while (requested)
+      {
+         const ptrdiff_t difference = sequenceDifference(tail);
+         if (difference < 0)
+         {
+            return 0;
+         }
+         if (difference > 0)
+         {
+            tail = m_tail.m_value.load(std::memory_order_relaxed);
+            continue;
+         }
+
+         // The consumer frees slots in order, so a range is free if its last slot is. When
+         // not all of the requested range is free, the free part of it is found by bisection.
+         count = requested;
+         if (sequenceDifference(tail + count - 1) != 0)
+         {
+            count = 1;
+            size_t limit = requested - 1;
+            while (count < limit)
+            {
+               const size_t middle = count + (limit - count + 1) / 2;
+               if (sequenceDifference(tail + middle - 1) == 0)
+               {
+                  count = middle;
+               }
+               else
+               {
+                  limit = middle - 1;
+               }
+            }
+         }
+
+         if (m_tail.m_value.compare_exchange_weak(tail, tail + count, std::memory_order_relaxed))
+         {
+            break;
+         }
+      }
+
+      for (size_t i = 0; i < count; ++i)
+      {
+         Slot& slot = m_slots[(tail + i) & m_mask];
+         slot.store(i_items[i]);
+         slot.m_sequence.store(tail + i + 1, std::memory_order_release);
+      }
+      return count;
+   }
+
+   // Pops up to i_maxCount items into o_items. Returns the number of items that were popped.
+   size_t popBatch(UniquePtr<T, D>* o_items, size_t i_maxCount)
+   {
+      size_t count = 0;
+      while (count < i_maxCount)
+      {
+         Slot& slot = m_slots[m_head & m_mask];
+         if (slot.m_sequence.load(std::memory_order_acquire) != m_head + 1)
+         {
+            break;
+         }
+
+         o_items[count++] = slot.take();
+         slot.m_sequence.store(m_head + capacity(), std::memory_order_release);
+         ++m_head;
+      }
+      return count;
+   }
+
+   MpscChannel(const MpscChannel&) = delete;
+   MpscChannel& operator = (const MpscChannel&) = delete;
+
+private:
+   struct Slot : public ChannelSlot<T, D>
+   {
+      std::atomic<size_t> m_sequence;
+   };
+
+   // Zero when the slot is free for the producer claiming i_position, negative while it still
+   // holds an item of the previous lap, positive once i_position was claimed.
+   ptrdiff_t sequenceDifference(size_t i_position) const
+   {
+      return static_cast<ptrdiff_t>(m_slots[i_position & m_mask].m_sequence.load(std::memory_order_acquire) - i_position);
+   }
+
+   const size_t m_mask;
+   UniquePtr<Slot[]> m_slots;
+   char m_padding[c_cacheLineSize];
+
+   // Written by the producers.
+   CacheLinePadded<std::atomic<size_t>> m_tail;
+
+   // Written by the consumer.
+   size_t m_head;
+   char m_consumerPadding[c_cacheLineSize];
+};
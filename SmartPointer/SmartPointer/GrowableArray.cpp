@@ -0,0 +1,291 @@
+#include "stdafx.h"
+#include "GrowableArray.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+   // Placed in front of the elements. Bytes of a mapping past the size of the elements are
+   // kept zero, so that growing into them needs no clearing.
+   struct GrowableHeader
+   {
+      size_t m_size;
+      // Accessible bytes of a mapping, header included. 0 for a malloc'ed block.
+      size_t m_mappedBytes;
+      // Reserved address space of a mapping, header included.
+      size_t m_reservedBytes;
+   };
+
+   const size_t c_headerSize = (sizeof(GrowableHeader) + std::alignment_of<std::max_align_t>::value - 1) /
+      std::alignment_of<std::max_align_t>::value * std::alignment_of<std::max_align_t>::value;
+
+   GrowableHeader* HeaderOf(void* i_data)
+   {
+      return reinterpret_cast<GrowableHeader*>(static_cast<char*>(i_data) - c_headerSize);
+   }
+
+   char* DataOf(GrowableHeader* i_header)
+   {
+      return reinterpret_cast<char*>(i_header) + c_headerSize;
+   }
+
+   // Returns 0 when the header and i_bytes do not fit into size_t.
+   size_t TotalBytes(size_t i_bytes)
+   {
+      return i_bytes <= static_cast<size_t>(-1) - c_headerSize ? c_headerSize + i_bytes : 0;
+   }
+
+   size_t PageSize()
+   {
+#ifdef _WIN32
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      return info.dwPageSize;
+#else
+      return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+   }
+
+   // Returns 0 on overflow.
+   size_t RoundToPages(size_t i_bytes)
+   {
+      const size_t pageSize = PageSize();
+      return i_bytes && i_bytes <= static_cast<size_t>(-1) - (pageSize - 1) ? (i_bytes + pageSize - 1) / pageSize * pageSize : 0;
+   }
+
+#ifdef _WIN32
+   // Reserves twice the mapped bytes when the address space allows it, so that the mapping can
+   // later grow in place.
+   GrowableHeader* MapPages(size_t i_mappedBytes)
+   {
+      size_t reservedBytes = i_mappedBytes <= static_cast<size_t>(-1) / 2 ? i_mappedBytes * 2 : i_mappedBytes;
+      void* base = VirtualAlloc(nullptr, reservedBytes, MEM_RESERVE, PAGE_NOACCESS);
+      if (!base && reservedBytes != i_mappedBytes)
+      {
+         reservedBytes = i_mappedBytes;
+         base = VirtualAlloc(nullptr, reservedBytes, MEM_RESERVE, PAGE_NOACCESS);
+      }
+      if (!base)
+      {
+         return nullptr;
+      }
+      if (!VirtualAlloc(base, i_mappedBytes, MEM_COMMIT, PAGE_READWRITE))
+      {
+         VirtualFree(base, 0, MEM_RELEASE);
+         return nullptr;
+      }
+
+      GrowableHeader* header = static_cast<GrowableHeader*>(base);
+      header->m_mappedBytes = i_mappedBytes;
+      header->m_reservedBytes = reservedBytes;
+      return header;
+   }
+
+   void UnmapPages(GrowableHeader* i_header)
+   {
+      VirtualFree(i_header, 0, MEM_RELEASE);
+   }
+
+   GrowableHeader* RemapPages(GrowableHeader* i_header, size_t i_mappedBytes)
+   {
+      char* base = reinterpret_cast<char*>(i_header);
+      const size_t mappedBytes = i_header->m_mappedBytes;
+      if (i_mappedBytes < mappedBytes)
+      {
+         VirtualFree(base + i_mappedBytes, mappedBytes - i_mappedBytes, MEM_DECOMMIT);
+      }
+      else if (i_mappedBytes <= i_header->m_reservedBytes)
+      {
+         if (!VirtualAlloc(base + mappedBytes, i_mappedBytes - mappedBytes, MEM_COMMIT, PAGE_READWRITE))
+         {
+            return nullptr;
+         }
+      }
+      else
+      {
+         // The reservation is outgrown, the array is copied into one twice as large.
+         GrowableHeader* moved = MapPages(i_mappedBytes);
+         if (!moved)
+         {
+            return nullptr;
+         }
+         std::memcpy(DataOf(moved), DataOf(i_header), i_header->m_size);
+         UnmapPages(i_header);
+         i_header = moved;
+      }
+
+      i_header->m_mappedBytes = i_mappedBytes;
+      return i_header;
+   }
+#else
+   GrowableHeader* MapPages(size_t i_mappedBytes)
+   {
+      void* base = mmap(nullptr, i_mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED)
+      {
+         return nullptr;
+      }
+
+      GrowableHeader* header = static_cast<GrowableHeader*>(base);
+      header->m_mappedBytes = i_mappedBytes;
+      header->m_reservedBytes = i_mappedBytes;
+      return header;
+   }
+
+   void UnmapPages(GrowableHeader* i_header)
+   {
+      munmap(i_header, i_header->m_reservedBytes);
+   }
+
+   GrowableHeader* RemapPages(GrowableHeader* i_header, size_t i_mappedBytes)
+   {
+#ifdef MREMAP_MAYMOVE
+      // The pages are moved to a new address when they can not be extended in place, their
+      // contents are not copied.
+      void* base = mremap(i_header, i_header->m_mappedBytes, i_mappedBytes, MREMAP_MAYMOVE);
+      if (base == MAP_FAILED)
+      {
+         return nullptr;
+      }
+      i_header = static_cast<GrowableHeader*>(base);
+#else
+      if (i_mappedBytes < i_header->m_mappedBytes)
+      {
+         munmap(reinterpret_cast<char*>(i_header) + i_mappedBytes, i_header->m_mappedBytes - i_mappedBytes);
+      }
+      else
+      {
+         GrowableHeader* moved = MapPages(i_mappedBytes);
+         if (!moved)
+         {
+            return nullptr;
+         }
+         std::memcpy(DataOf(moved), DataOf(i_header), i_header->m_size);
+         UnmapPages(i_header);
+         i_header = moved;
+      }
+#endif
+
+      i_header->m_mappedBytes = i_mappedBytes;
+      i_header->m_reservedBytes = i_mappedBytes;
+      return i_header;
+   }
+#endif
+}
+
+void* AllocateGrowable(size_t i_bytes)
+{
+   const size_t totalBytes = TotalBytes(i_bytes);
+   if (!totalBytes)
+   {
+      return nullptr;
+   }
+
+   GrowableHeader* header = nullptr;
+   if (totalBytes < c_growablePagesThreshold)
+   {
+      header = static_cast<GrowableHeader*>(std::calloc(1, totalBytes));
+      if (header)
+      {
+         header->m_mappedBytes = 0;
+         header->m_reservedBytes = 0;
+      }
+   }
+   else
+   {
+      const size_t mappedBytes = RoundToPages(totalBytes);
+      header = mappedBytes ? MapPages(mappedBytes) : nullptr;
+   }
+
+   if (!header)
+   {
+      return nullptr;
+   }
+   header->m_size = i_bytes;
+   return DataOf(header);
+}
+
+void* ResizeGrowable(void* i_data, size_t i_bytes)
+{
+   GrowableHeader* header = HeaderOf(i_data);
+   const size_t size = header->m_size;
+   const size_t totalBytes = TotalBytes(i_bytes);
+   if (!totalBytes)
+   {
+      return nullptr;
+   }
+
+   if (!header->m_mappedBytes && totalBytes < c_growablePagesThreshold)
+   {
+      header = static_cast<GrowableHeader*>(std::realloc(header, totalBytes));
+      if (!header)
+      {
+         return nullptr;
+      }
+      if (i_bytes > size)
+      {
+         std::memset(DataOf(header) + size, 0, i_bytes - size);
+      }
+   }
+   else if (!header->m_mappedBytes)
+   {
+      // The only copy of a growing array that does not outgrow a reservation: the malloc'ed
+      // block, smaller than c_growablePagesThreshold, is moved into fresh zero-filled pages.
+      const size_t mappedBytes = RoundToPages(totalBytes);
+      GrowableHeader* mapped = mappedBytes ? MapPages(mappedBytes) : nullptr;
+      if (!mapped)
+      {
+         return nullptr;
+      }
+      std::memcpy(DataOf(mapped), i_data, size);
+      std::free(header);
+      header = mapped;
+   }
+   else
+   {
+      const size_t mappedBytes = RoundToPages(totalBytes);
+      if (!mappedBytes)
+      {
+         return nullptr;
+      }
+      if (mappedBytes != header->m_mappedBytes)
+      {
+         header = RemapPages(header, mappedBytes);
+         if (!header)
+         {
+            return nullptr;
+         }
+      }
+      if (i_bytes < size)
+      {
+         // What is left of the truncated elements in the last page is cleared.
+         std::memset(DataOf(header) + i_bytes, 0, std::min(size, mappedBytes - c_headerSize) - i_bytes);
+      }
+   }
+
+   header->m_size = i_bytes;
+   return DataOf(header);
+}
+
+void FreeGrowable(void* i_data)
+{
+   GrowableHeader* header = HeaderOf(i_data);
+   if (header->m_mappedBytes)
+   {
+      UnmapPages(header);
+   }
+   else
+   {
+      std::free(header);
+   }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "UniquePtr.h"
+
+#include <cstddef>
+#include <new>
+
+// Arrays that can be grown without allocating, copying and destroying the whole buffer.
+//
+// Elements are never constructed or destroyed, every element is zero-filled when the array is
+// created and when it grows. Small arrays live in malloc'ed blocks and are grown with realloc.
+// Past c_growablePagesThreshold bytes the array moves once into memory mapped by pages and
+// stays there. From then on growing it does not copy the elements: mremap moves the pages
+// elsewhere, on Windows pages are committed in place within a reservation of twice the
+// requested size, and only outgrowing the reservation copies the array into a new one.
+//
+// The storage functions are defined in GrowableArray.cpp and work on the address of the first
+// element, the bookkeeping is kept in front of it.
+
+const size_t c_growablePagesThreshold = 256 * 1024;
+
+// Returns zero-filled storage for i_bytes, or null if it can not be allocated.
+void* AllocateGrowable(size_t i_bytes);
+
+// Returns the storage resized to i_bytes, bytes past the old size are zero-filled. The storage
+// may have moved. On failure null is returned and the storage is left untouched.
+void* ResizeGrowable(void* i_data, size_t i_bytes);
+
+void FreeGrowable(void* i_data);
+
+template<class T>
+struct GrowableDeleter;
+
+template<class T>
+struct GrowableDeleter<T[]>
+{
+   GrowableDeleter() = default;
+
+   void operator()(T* i_ptr) const
+   {
+      FreeGrowable(i_ptr);
+   }
+
+   template <class TOtherType>
+   void operator()(TOtherType*) const = delete;
+};
+
+template <class T>
+using GrowableUniquePtr = UniquePtr<T[], GrowableDeleter<T[]>>;
+
+template <class T>
+size_t GrowableBytes(size_t i_size)
+{
+   static_assert(std::is_trivial<T>::value, "Growable arrays require a trivial element type.");
+   static_assert(std::alignment_of<T>::value <= std::alignment_of<std::max_align_t>::value, "Over-aligned types can not be placed in a growable array.");
+
+   if (i_size > static_cast<size_t>(-1) / sizeof(T))
+   {
+      throw std::bad_alloc();
+   }
+   return i_size * sizeof(T);
+}
+
+template <class T, class = std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0>>
+GrowableUniquePtr<std::remove_extent_t<T>> MakeUniqueGrowable(size_t i_size)
+{
+   using element_type = std::remove_extent_t<T>;
+
+   void* data = AllocateGrowable(GrowableBytes<element_type>(i_size));
+   if (!data)
+   {
+      throw std::bad_alloc();
+   }
+   return GrowableUniquePtr<element_type>(static_cast<element_type*>(data));
+}
+
+// Resizes the array to i_newSize elements, elements past the old size are zero-filled. On
+// failure std::bad_alloc is thrown and the array is left untouched.
+template <class T>
+void ResizeUnique(GrowableUniquePtr<T>& i_array, size_t i_newSize)
+{
+   if (!i_newSize)
+   {
+      i_array.reset();
+      return;
+   }
+
+   const size_t bytes = GrowableBytes<T>(i_newSize);
+   void* data = i_array ? ResizeGrowable(i_array.get(), bytes) : AllocateGrowable(bytes);
+   if (!data)
+   {
+      throw std::bad_alloc();
+   }
+   i_array.release();
+   i_array.reset(static_cast<T*>(data));
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "UniquePtr.h"
+
+#include <atomic>
+
+// Counting policies of RefCounted. decrement returns true when the last reference is dropped.
+struct AtomicCountPolicy
+{
+   using counter_type = std::atomic<size_t>;
+
+   static void increment(counter_type& i_counter)
+   {
+      i_counter.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   static bool decrement(counter_type& i_counter)
+   {
+      return i_counter.fetch_sub(1, std::memory_order_acq_rel) == 1;
+   }
+
+   static size_t load(const counter_type& i_counter)
+   {
+      return i_counter.load(std::memory_order_relaxed);
+   }
+};
+
+struct PlainCountPolicy
+{
+   using counter_type = size_t;
+
+   static void increment(counter_type& i_counter)
+   {
+      ++i_counter;
+   }
+
+   static bool decrement(counter_type& i_counter)
+   {
+      return --i_counter == 0;
+   }
+
+   static size_t load(const counter_type& i_counter)
+   {
+      return i_counter;
+   }
+};
+
+// Base class embedding the reference count used by IntrusivePtr. Copies of an object start
+// unreferenced, the count belongs to the object and not to its value.
+template <class TCountPolicy = AtomicCountPolicy>
+class RefCounted
+{
+public:
+   RefCounted() : m_references(0)
+   {
+   }
+
+   RefCounted(const RefCounted&) : m_references(0)
+   {
+   }
+
+   RefCounted& operator=(const RefCounted&)
+   {
+      return *this;
+   }
+
+   mutable typename TCountPolicy::counter_type m_references;
+};
+
+// Shared owner of an object deriving from RefCounted<TCountPolicy>. The object is destroyed
+// with the deleter D when the last IntrusivePtr releases it.
+template <class T, class TCountPolicy = AtomicCountPolicy, class D = DefaultDeleter<T>>
+class IntrusivePtr : public PointerStorage<T, D, std::is_empty<D>::value>
+{
+   using Storage = PointerStorage<T, D, std::is_empty<D>::value>;
+
+public:
+   using typename Storage::pointer;
+   using typename Storage::element_type;
+   using typename Storage::deleter_type;
+   using Storage::get_deleter;
+
+   static_assert(std::is_base_of<RefCounted<TCountPolicy>, T>::value, "IntrusivePtr requires T to derive from RefCounted with the same count policy.");
+
+   IntrusivePtr() : Storage(nullptr)
+   {
+   }
+
+   IntrusivePtr(nullptr_t) : Storage(nullptr)
+   {
+   }
+
+   explicit IntrusivePtr(pointer i_pointer) : Storage(i_pointer)
+   {
+      acquire(i_pointer);
+   }
+
+   IntrusivePtr(pointer i_pointer, const D& i_deleter) : Storage(i_pointer, i_deleter)
+   {
+      acquire(i_pointer);
+   }
+
+   // Takes over the object of a UniquePtr, it keeps its allocation and its deleter.
+   IntrusivePtr(UniquePtr<T, D>&& i_uniquePtr) : Storage(nullptr, std::move(i_uniquePtr.get_deleter()))
+   {
+      this->m_pointer = i_uniquePtr.release();
+      acquire(this->m_pointer);
+   }
+
+   IntrusivePtr(const IntrusivePtr& i_other) : Storage(i_other.m_pointer, i_other.get_deleter())
+   {
+      acquire(this->m_pointer);
+   }
+
+   IntrusivePtr(IntrusivePtr&& i_other) : Storage(i_other.m_pointer, std::move(i_other.get_deleter()))
+   {
+      i_other.m_pointer = nullptr;
+   }
+
+   IntrusivePtr& operator=(const IntrusivePtr& i_other)
+   {
+      IntrusivePtr(i_other).swap(*this);
+      return *this;
+   }
+
+   IntrusivePtr& operator=(IntrusivePtr&& i_other)
+   {
+      IntrusivePtr(std::move(i_other)).swap(*this);
+      return *this;
+   }
+
+   IntrusivePtr& operator=(nullptr_t)
+   {
+      reset();
+      return *this;
+   }
+
+   ~IntrusivePtr()
+   {
+      reset();
+   }
+
+   void reset(pointer i_pointer = nullptr)
+   {
+      acquire(i_pointer);
+      pointer temp = this->m_pointer;
+      this->m_pointer = i_pointer;
+
+      if (temp && TCountPolicy::decrement(counted(temp).m_references))
+      {
+         get_deleter()(temp);
+      }
+   }
+
+   pointer get() const
+   {
+      return this->m_pointer;
+   }
+
+   size_t use_count() const
+   {
+      return this->m_pointer ? TCountPolicy::load(counted(this->m_pointer).m_references) : 0;
+   }
+
+   void swap(IntrusivePtr& i_other)
+   {
+      std::swap(this->m_pointer, i_other.m_pointer);
+      std::swap(get_deleter(), i_other.get_deleter());
+   }
+
+   pointer operator->() const
+   {
+      return this->m_pointer;
+   }
+
+   element_type& operator*() const
+   {
+      return *this->m_pointer;
+   }
+
+   explicit operator bool() const
+   {
+      return this->m_pointer != nullptr;
+   }
+
+private:
+   static const RefCounted<TCountPolicy>& counted(pointer i_pointer)
+   {
+      return *i_pointer;
+   }
+
+   static void acquire(pointer i_pointer)
+   {
+      if (i_pointer)
+      {
+         TCountPolicy::increment(counted(i_pointer).m_references);
+      }
+   }
+};
+
+template <class T, class TCountPolicy, class D>
+void swap(IntrusivePtr<T, TCountPolicy, D>& i_lhs, IntrusivePtr<T, TCountPolicy, D>& i_rhs)
+{
+   i_lhs.swap(i_rhs);
+}
+
+template <class T, class P, class D, class T2, class P2, class D2>
+bool operator==(const IntrusivePtr<T, P, D>& i_lhs, const IntrusivePtr<T2, P2, D2>& i_rhs)
+{
+   return i_lhs.get() == i_rhs.get();
+}
+
+template <class T, class P, class D, class T2, class P2, class D2>
+bool operator!=(const IntrusivePtr<T, P, D>& i_lhs, const IntrusivePtr<T2, P2, D2>& i_rhs)
+{
+   return !(i_lhs == i_rhs);
+}
+
+template <class T, class P, class D>
+bool operator==(const IntrusivePtr<T, P, D>& i_lhs, nullptr_t)
+{
+   return !i_lhs.get();
+}
+
+template <class T, class P, class D>
+bool operator!=(const IntrusivePtr<T, P, D>& i_lhs, nullptr_t i_rhs)
+{
+   return !(i_lhs == i_rhs);
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "UniquePtr.h"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+// Objects created with MakeUniquePromotable share one allocation with a reference count placed
+// right in front of them. While the object is uniquely owned the count is unused, promoting
+// the UniquePtr to a SharedPtr starts counting without any further allocation.
+
+template <class T>
+struct PromotableBlock
+{
+   // The block comes from plain new, which only aligns for the fundamental types.
+   static_assert(std::alignment_of<T>::value <= std::alignment_of<std::max_align_t>::value, "Over-aligned types can not be created with MakeUniquePromotable.");
+
+   PromotableBlock() : m_references(0)
+   {
+   }
+
+   T* object()
+   {
+      return reinterpret_cast<T*>(&m_storage);
+   }
+
+   static PromotableBlock* FromObject(T* i_object)
+   {
+      return reinterpret_cast<PromotableBlock*>(reinterpret_cast<char*>(i_object) - offsetof(PromotableBlock, m_storage));
+   }
+
+   static void Destroy(T* i_object)
+   {
+      i_object->~T();
+      delete FromObject(i_object);
+   }
+
+   std::atomic<size_t> m_references;
+   typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type m_storage;
+};
+
+// The block is found from the object address, so the deleter is empty and does not convert
+// between related types: a base class subobject may not start where the object does.
+template<class T>
+struct PromotableDeleter
+{
+   void operator()(T* i_ptr) const
+   {
+      PromotableBlock<T>::Destroy(i_ptr);
+   }
+};
+
+template <class T>
+using PromotableUniquePtr = UniquePtr<T, PromotableDeleter<T>>;
+
+template <class T, class... TParams, class = std::enable_if_t<!std::is_array<T>::value>>
+PromotableUniquePtr<T> MakeUniquePromotable(TParams&&... i_params)
+{
+   UniquePtr<PromotableBlock<T>> block(new PromotableBlock<T>());
+   new (block->object()) T(std::forward<TParams>(i_params)...);
+   return PromotableUniquePtr<T>(block.release()->object());
+}
+
+// Shared owner of an object created with MakeUniquePromotable. It is the size of a pointer,
+// the reference count is kept in front of the object.
+template <class T>
+class SharedPtr
+{
+public:
+   SharedPtr() : m_pointer(nullptr)
+   {
+   }
+
+   SharedPtr(nullptr_t) : m_pointer(nullptr)
+   {
+   }
+
+   SharedPtr(PromotableUniquePtr<T>&& i_uniquePtr) : m_pointer(i_uniquePtr.release())
+   {
+      if (m_pointer)
+      {
+         block()->m_references.store(1, std::memory_order_relaxed);
+      }
+   }
+
+   SharedPtr(const SharedPtr& i_other) : m_pointer(i_other.m_pointer)
+   {
+      if (m_pointer)
+      {
+         block()->m_references.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+
+   SharedPtr(SharedPtr&& i_other) : m_pointer(i_other.m_pointer)
+   {
+      i_other.m_pointer = nullptr;
+   }
+
+   SharedPtr& operator=(const SharedPtr& i_other)
+   {
+      SharedPtr(i_other).swap(*this);
+      return *this;
+   }
+
+   SharedPtr& operator=(SharedPtr&& i_other)
+   {
+      SharedPtr(std::move(i_other)).swap(*this);
+      return *this;
+   }
+
+   SharedPtr& operator=(nullptr_t)
+   {
+      reset();
+      return *this;
+   }
+
+   ~SharedPtr()
+   {
+      reset();
+   }
+
+   void reset()
+   {
+      T* temp = m_pointer;
+      m_pointer = nullptr;
+
+      if (temp && PromotableBlock<T>::FromObject(temp)->m_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+         PromotableBlock<T>::Destroy(temp);
+      }
+   }
+
+   T* get() const
+   {
+      return m_pointer;
+   }
+
+   size_t use_count() const
+   {
+      return m_pointer ? block()->m_references.load(std::memory_order_relaxed) : 0;
+   }
+
+   void swap(SharedPtr& i_other)
+   {
+      std::swap(m_pointer, i_other.m_pointer);
+   }
+
+   T* operator->() const
+   {
+      return m_pointer;
+   }
+
+   T& operator*() const
+   {
+      return *m_pointer;
+   }
+
+   explicit operator bool() const
+   {
+      return m_pointer != nullptr;
+   }
+
+private:
+   PromotableBlock<T>* block() const
+   {
+      return PromotableBlock<T>::FromObject(m_pointer);
+   }
+
+   T* m_pointer;
+};
+
+template <class T>
+SharedPtr<T> Promote(PromotableUniquePtr<T>&& i_uniquePtr)
+{
+   return SharedPtr<T>(std::move(i_uniquePtr));
+}
+
+template <class T>
+void swap(SharedPtr<T>& i_lhs, SharedPtr<T>& i_rhs)
+{
+   i_lhs.swap(i_rhs);
+}
+
+template <class T, class T2>
+bool operator==(const SharedPtr<T>& i_lhs, const SharedPtr<T2>& i_rhs)
+{
+   return i_lhs.get() == i_rhs.get();
+}
+
+template <class T, class T2>
+bool operator!=(const SharedPtr<T>& i_lhs, const SharedPtr<T2>& i_rhs)
+{
+   return !(i_lhs == i_rhs);
+}
+
+template <class T>
+bool operator==(const SharedPtr<T>& i_lhs, nullptr_t)
+{
+   return !i_lhs.get();
+}
+
+template <class T>
+bool operator!=(const SharedPtr<T>& i_lhs, nullptr_t i_rhs)
+{
+   return !(i_lhs == i_rhs);
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "UniquePtr.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <vector>
+
+inline void DeleteSlabMemory(void* i_memory, size_t)
+{
+   ::operator delete(i_memory);
+}
+
+// Header placed in front of the objects of a batch allocation. Every SlabDeleter referring to
+// the slab holds one reference, the slab memory is handed to the release function when the
+// last one is destroyed.
+struct SlabHeader
+{
+   using ReleaseFunction = void(*)(void* i_memory, size_t i_size);
+
+   SlabHeader(size_t i_size, size_t i_references, ReleaseFunction i_release = &DeleteSlabMemory) :
+      m_size(i_size),
+      m_references(i_references),
+      m_release(i_release)
+   {
+   }
+
+   bool contains(const void* i_ptr) const
+   {
+      const char* begin = reinterpret_cast<const char*>(this);
+      const char* ptr = static_cast<const char*>(i_ptr);
+      return !std::less<const char*>()(ptr, begin) && std::less<const char*>()(ptr, begin + m_size);
+   }
+
+   void addReference()
+   {
+      m_references.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   void dropReference()
+   {
+      if (m_references.fetch_sub(1) == 1)
+      {
+         const ReleaseFunction release = m_release;
+         const size_t size = m_size;
+         this->~SlabHeader();
+         release(this, size);
+      }
+   }
+
+   const size_t m_size;
+   std::atomic<size_t> m_references;
+   const ReleaseFunction m_release;
+};
+
+// Tag of the SlabDeleter constructor taking over a reference already counted in the slab.
+struct AdoptSlabReference
+{
+};
+
+struct SlabReleaser
+{
+   void operator()(SlabHeader* i_slab) const
+   {
+      i_slab->dropReference();
+   }
+};
+
+// Deleter of objects allocated in a slab. It decides per pointer: objects inside its slab are
+// only destroyed, anything else is deleted. Holding a reference keeps the slab alive as long as
+// the deleter can be asked about it, so a SlabUniquePtr can be reset with a heap object, or
+// swapped with a pointer of another slab, like any other UniquePtr.
+template<class T>
+struct SlabDeleter
+{
+   template<class TOther, class = std::enable_if_t<std::is_convertible<TOther *, T *>::value>>
+   SlabDeleter(const SlabDeleter<TOther>& i_other) : m_slab(i_other.m_slab)
+   {
+      addReference();
+   }
+
+   template<class TOther, class = std::enable_if_t<std::is_convertible<TOther *, T *>::value>>
+   SlabDeleter(SlabDeleter<TOther>&& i_other) : m_slab(i_other.m_slab)
+   {
+      i_other.m_slab = nullptr;
+   }
+
+   SlabDeleter() : m_slab(nullptr)
+   {
+   }
+
+   explicit SlabDeleter(SlabHeader* i_slab) : m_slab(i_slab)
+   {
+      addReference();
+   }
+
+   SlabDeleter(SlabHeader* i_slab, AdoptSlabReference) : m_slab(i_slab)
+   {
+   }
+
+   SlabDeleter(const SlabDeleter& i_other) : m_slab(i_other.m_slab)
+   {
+      addReference();
+   }
+
+   SlabDeleter(SlabDeleter&& i_other) : m_slab(i_other.m_slab)
+   {
+      i_other.m_slab = nullptr;
+   }
+
+   SlabDeleter& operator=(SlabDeleter i_other)
+   {
+      std::swap(m_slab, i_other.m_slab);
+      return *this;
+   }
+
+   ~SlabDeleter()
+   {
+      if (m_slab)
+      {
+         m_slab->dropReference();
+      }
+   }
+
+   void operator()(T* i_ptr) const
+   {
+      if (m_slab && m_slab->contains(i_ptr))
+      {
+         i_ptr->~T();
+      }
+      else
+      {
+         delete i_ptr;
+      }
+   }
+
+   SlabHeader* m_slab;
+
+private:
+   void addReference()
+   {
+      if (m_slab)
+      {
+         m_slab->addReference();
+      }
+   }
+};
+
+template <class T>
+using SlabUniquePtr = UniquePtr<T, SlabDeleter<T>>;
+
+template <class T>
+size_t SlabObjectsOffset()
+{
+   const size_t alignment = std::alignment_of<T>::value;
+   return (sizeof(SlabHeader) + alignment - 1) / alignment * alignment;
+}
+
+template <class T>
+T* SlabObjects(SlabHeader* i_slab)
+{
+   return reinterpret_cast<T*>(reinterpret_cast<char*>(i_slab) + SlabObjectsOffset<T>());
+}
+
+// Allocates uninitialized storage for i_count objects of type T. The returned pointer holds
+// the only reference to the slab, the deleters of the objects placed into it add their own.
+template <class T>
+UniquePtr<SlabHeader, SlabReleaser> AllocateSlab(size_t i_count)
+{
+   // The slab comes from ::operator new, which only aligns for the fundamental types.
+   static_assert(std::alignment_of<T>::value <= std::alignment_of<std::max_align_t>::value, "Over-aligned types can not be placed in a slab.");
+
+   const size_t objectsOffset = SlabObjectsOffset<T>();
+   if (i_count > (static_cast<size_t>(-1) - objectsOffset) / sizeof(T))
+   {
+      throw std::bad_alloc();
+   }
+
+   const size_t size = objectsOffset + i_count * sizeof(T);
+   void* memory = ::operator new(size);
+   return UniquePtr<SlabHeader, SlabReleaser>(new (memory) SlabHeader(size, 1));
+}
+
+// Constructs i_count objects from the same arguments in one contiguous allocation.
+// Each returned pointer owns its object independently.
+template <class T, class... TParams, class = std::enable_if_t<!std::is_array<T>::value>>
+std::vector<SlabUniquePtr<T>> MakeUniqueBatch(size_t i_count, const TParams&... i_params)
+{
+   // The batch holds its own reference until all objects are constructed, so the slab is
+   // freed together with the already constructed objects if a constructor throws.
+   auto slab = AllocateSlab<T>(i_count);
+   std::vector<SlabUniquePtr<T>> batch;
+   batch.reserve(i_count);
+
+   T* objects = SlabObjects<T>(slab.get());
+   for (size_t i = 0; i < i_count; ++i)
+   {
+      T* object = new (objects + i) T(i_params...);
+      batch.emplace_back(object, SlabDeleter<T>(slab.get()));
+   }
+
+   return batch;
+}
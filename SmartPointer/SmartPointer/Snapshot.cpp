@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "Snapshot.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+void* MapSnapshotFile(const char* i_path, size_t& o_size)
+{
+   HANDLE file = CreateFileA(i_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if (file == INVALID_HANDLE_VALUE)
+   {
+      return nullptr;
+   }
+
+   void* image = nullptr;
+   LARGE_INTEGER size;
+   if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && static_cast<unsigned long long>(size.QuadPart) <= static_cast<size_t>(-1))
+   {
+      // A copy-on-write view, the mapping object is kept alive by the view.
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+      if (mapping)
+      {
+         image = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, static_cast<size_t>(size.QuadPart));
+         CloseHandle(mapping);
+      }
+   }
+   CloseHandle(file);
+
+   if (image)
+   {
+      o_size = static_cast<size_t>(size.QuadPart);
+   }
+   return image;
+}
+
+void UnmapSnapshotFile(void* i_image, size_t)
+{
+   UnmapViewOfFile(i_image);
+}
+#else
+void* MapSnapshotFile(const char* i_path, size_t& o_size)
+{
+   const int file = open(i_path, O_RDONLY);
+   if (file < 0)
+   {
+      return nullptr;
+   }
+
+   void* image = nullptr;
+   struct stat status;
+   if (fstat(file, &status) == 0 && status.st_size > 0 && static_cast<unsigned long long>(status.st_size) <= static_cast<size_t>(-1))
+   {
+      // Private pages are copied on write, the file is never modified.
+      image = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+      if (image == MAP_FAILED)
+      {
+         image = nullptr;
+      }
+   }
+   close(file);
+
+   if (image)
+   {
+      o_size = static_cast<size_t>(status.st_size);
+   }
+   return image;
+}
+
+void UnmapSnapshotFile(void* i_image, size_t i_size)
+{
+   munmap(i_image, i_size);
+}
+#endif
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "Slab.h"
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// Snapshots of trees of nodes owned through SlabUniquePtr<T>.
+//
+// The node type has to provide
+//    template <class TVisitor> void forEachChild(TVisitor&& i_visitor) const
+// calling i_visitor with every SlabUniquePtr<T> child member. Nodes are stored and restored
+// byte by byte into storage where no constructor ever runs, so apart from the children a node
+// must hold plain values only: any other pointer or owning member (a std::string, a
+// std::vector, a UniquePtr that is not reported as a child) is silently corrupted, and
+// polymorphic types are rejected since a vptr is meaningless in another process.
+//
+// The nodes are written one by one into an image with child pointers replaced by node indices,
+// so writing holds a single node copy besides a pointer per node. Restoring maps the file
+// copy-on-write and restores the nodes where they lie in the view: the snapshot header is
+// replaced by the header of a slab and the indices are turned back into pointers in place,
+// writes never reach the file. Nothing is copied, a restore reads every node once to validate
+// and once to link it, and those reads are what pages the file in. The deleter of every
+// restored link holds a reference on the slab, the view is unmapped with the last of them.
+
+struct SnapshotHeader
+{
+   uint64_t m_magic;
+   uint64_t m_nodeSize;
+   uint64_t m_nodeAlignment;
+   uint64_t m_nodeCount;
+};
+
+const uint64_t c_snapshotMagic = 0x31504e5355505055ull;
+
+// Maps the whole file copy-on-write and stores its size into o_size. Returns null if the file
+// can not be mapped or is empty. The functions are defined in Snapshot.cpp.
+void* MapSnapshotFile(const char* i_path, size_t& o_size);
+
+void UnmapSnapshotFile(void* i_image, size_t i_size);
+
+struct SnapshotUnmapper
+{
+   void operator()(char* i_image) const
+   {
+      UnmapSnapshotFile(i_image, m_size);
+   }
+
+   size_t m_size;
+};
+
+template <class T>
+SnapshotHeader MakeSnapshotHeader(uint64_t i_nodeCount)
+{
+   SnapshotHeader header = { c_snapshotMagic, sizeof(T), std::alignment_of<T>::value, i_nodeCount };
+   return header;
+}
+
+template <class T>
+void WriteSnapshot(const SlabUniquePtr<T>& i_root, std::ostream& i_stream)
+{
+   static_assert(sizeof(SlabUniquePtr<T>) >= sizeof(uint64_t), "Child link does not fit into a node index.");
+   static_assert(!std::is_polymorphic<T>::value, "Snapshots of polymorphic nodes are not supported.");
+
+   // Nodes are numbered in breadth-first order, index 0 stands for a null child. The order is
+   // collected first, since the header written in front of the nodes holds their count.
+   std::vector<const T*> nodes;
+   if (i_root)
+   {
+      nodes.push_back(i_root.get());
+   }
+   for (size_t i = 0; i < nodes.size(); ++i)
+   {
+      nodes[i]->forEachChild([&](const SlabUniquePtr<T>& i_child)
+      {
+         if (i_child)
+         {
+            nodes.push_back(i_child.get());
+         }
+      });
+   }
+
+   const SnapshotHeader header = MakeSnapshotHeader<T>(nodes.size());
+   i_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+   // Children are numbered in the same order again while every node is copied, patched and
+   // written out on its own.
+   typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type buffer;
+   char* copy = reinterpret_cast<char*>(&buffer);
+   uint64_t numbered = 1;
+   for (size_t i = 0; i < nodes.size() && i_stream; ++i)
+   {
+      const char* node = reinterpret_cast<const char*>(nodes[i]);
+      std::memcpy(copy, node, sizeof(T));
+
+      nodes[i]->forEachChild([&](const SlabUniquePtr<T>& i_child)
+      {
+         const uint64_t link = i_child ? ++numbered : 0;
+         char* field = copy + (reinterpret_cast<const char*>(&i_child) - node);
+         std::memset(field, 0, sizeof(SlabUniquePtr<T>));
+         std::memcpy(field, &link, sizeof(link));
+      });
+      i_stream.write(copy, sizeof(T));
+   }
+
+   if (!i_stream)
+   {
+      throw std::runtime_error("Failed to write snapshot.");
+   }
+}
+
+template <class T>
+SlabUniquePtr<T> ReadSnapshot(const char* i_path)
+{
+   static_assert(!std::is_polymorphic<T>::value, "Snapshots of polymorphic nodes are not supported.");
+   static_assert(sizeof(SlabHeader) <= sizeof(SnapshotHeader), "Slab header does not fit in place of the snapshot header.");
+   static_assert(sizeof(SnapshotHeader) % std::alignment_of<T>::value == 0, "Nodes are not aligned in a mapped snapshot.");
+
+   size_t imageSize = 0;
+   void* image = MapSnapshotFile(i_path, imageSize);
+   if (!image)
+   {
+      throw std::runtime_error("Failed to map snapshot.");
+   }
+   UniquePtr<char, SnapshotUnmapper> mapped(static_cast<char*>(image), SnapshotUnmapper{ imageSize });
+
+   SnapshotHeader header = {};
+   if (imageSize >= sizeof(header))
+   {
+      std::memcpy(&header, image, sizeof(header));
+   }
+   const SnapshotHeader expected = MakeSnapshotHeader<T>(header.m_nodeCount);
+   if (imageSize < sizeof(header) || std::memcmp(&header, &expected, sizeof(header)) != 0)
+   {
+      throw std::runtime_error("Snapshot does not match the node type.");
+   }
+
+   // Compared before the count is narrowed to size_t, which is 32 bits on Win32.
+   if (header.m_nodeCount > static_cast<size_t>(-1) / sizeof(T) ||
+      header.m_nodeCount > (imageSize - sizeof(header)) / sizeof(T))
+   {
+      throw std::runtime_error("Snapshot is truncated.");
+   }
+
+   if (!header.m_nodeCount)
+   {
+      return SlabUniquePtr<T>();
+   }
+
+   const size_t nodeCount = static_cast<size_t>(header.m_nodeCount);
+   T* nodes = reinterpret_cast<T*>(mapped.get() + sizeof(header));
+
+   // Links are validated before any of them is turned into an owning pointer, so a corrupt
+   // image is rejected without destroying nodes that were never restored. Every node but the
+   // root has to be owned exactly once, by a node that precedes it.
+   std::vector<bool> owned(nodeCount, false);
+   for (size_t i = 0; i < nodeCount; ++i)
+   {
+      nodes[i].forEachChild([&](const SlabUniquePtr<T>& i_child)
+      {
+         uint64_t link;
+         std::memcpy(&link, &i_child, sizeof(link));
+         if (link && (link <= i + 1 || link > nodeCount || owned[static_cast<size_t>(link - 1)]))
+         {
+            throw std::runtime_error("Snapshot contains an invalid child link.");
+         }
+         if (link)
+         {
+            owned[static_cast<size_t>(link - 1)] = true;
+         }
+      });
+   }
+   for (size_t i = 1; i < nodeCount; ++i)
+   {
+      if (!owned[i])
+      {
+         throw std::runtime_error("Snapshot contains an unreachable node.");
+      }
+   }
+
+   // The root and every other node are owned by exactly one link, so the slab starts with a
+   // reference for each node and the deleters of the links take them over.
+   SlabHeader* slab = new (mapped.release()) SlabHeader(imageSize, nodeCount, &UnmapSnapshotFile);
+   for (size_t i = 0; i < nodeCount; ++i)
+   {
+      nodes[i].forEachChild([&](const SlabUniquePtr<T>& i_child)
+      {
+         uint64_t link;
+         std::memcpy(&link, &i_child, sizeof(link));
+         T* child = link ? nodes + (link - 1) : nullptr;
+         new (const_cast<SlabUniquePtr<T>*>(&i_child)) SlabUniquePtr<T>(child, child ? SlabDeleter<T>(slab, AdoptSlabReference()) : SlabDeleter<T>());
+      });
+   }
+
+   return SlabUniquePtr<T>(nodes, SlabDeleter<T>(slab, AdoptSlabReference()));
+}
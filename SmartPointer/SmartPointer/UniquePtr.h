@@ -1,5 +1,8 @@
 #pragma once
 
+#include <type_traits>
+#include <utility>
+
 template <class... Params>
 struct voider{ using type = void; };
 
@@ -23,6 +26,395 @@ using pointer_member_or_default_t = typename pointer_member_or_default<T, Defaul
 
 
 
+// Checked ownership mode, enabled by defining UNIQUE_PTR_CHECKED.
+//
+// Every thread records one in UNIQUE_PTR_CHECK_SAMPLING_RATE of its allocations made through
+// MakeUnique with their type and array-ness. For recorded objects it is reported when a second
+// UniquePtr takes ownership of an already owned pointer, and when DefaultDeleter destroys an
+// array as a single object or the other way around, as through a UniquePtr<T, DefaultDeleter<T[]>>
+// converted from MakeUnique<T>().
+//
+// A record follows its object through moves between UniquePtrs, conversions to a base class at
+// another address included. It is erased when the object is destroyed, and when release() hands
+// it out of the UniquePtr family, since whatever frees it next is not seen and its address may be
+// reused by an unrelated object. So only violations within one unbroken ownership are reported,
+// never one made up from a reused address. Not checked are an object adopted after release(),
+// such as UniquePtr<int>(MakeUnique<int[]>(n).release()), and a second deletion of an object,
+// whose record was erased by the first. Objects that are never destroyed stay counted by
+// sampledAllocations().
+//
+// Records are looked up through 2^UNIQUE_PTR_CHECK_FILTER_BITS counters. Ownership changes of a
+// pointer whose counter is zero take no lock, only relaxed loads of the counter and of the
+// checker state, and allocations count down a thread-local sampling counter. The filter should be
+// several times larger than the number of recorded objects alive at once, that is the live
+// objects divided by the sampling rate, as pointers sharing a counter with a record take a lock.
+#ifdef UNIQUE_PTR_CHECKED
+
+#include "CacheLine.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
+
+#ifndef UNIQUE_PTR_CHECK_SAMPLING_RATE
+#define UNIQUE_PTR_CHECK_SAMPLING_RATE 1000
+#endif
+
+#ifndef UNIQUE_PTR_CHECK_FILTER_BITS
+#define UNIQUE_PTR_CHECK_FILTER_BITS 18
+#endif
+
+enum class OwnershipViolationKind
+{
+   DoubleOwnership,
+   MismatchedDeleter
+};
+
+struct OwnershipViolation
+{
+   OwnershipViolationKind m_kind;
+   const void* m_pointer;
+   const char* m_typeName;
+   bool m_allocatedAsArray;
+};
+
+class OwnershipChecker
+{
+public:
+   using ViolationHandler = void(*)(const OwnershipViolation&);
+
+   // A rate of 0 stops sampling new allocations.
+   static void setSamplingRate(size_t i_rate)
+   {
+      state().m_samplingRate.store(i_rate, std::memory_order_relaxed);
+   }
+
+   static ViolationHandler setViolationHandler(ViolationHandler i_handler)
+   {
+      return state().m_handler.exchange(i_handler ? i_handler : &ReportToStderr);
+   }
+
+   static size_t sampledAllocations()
+   {
+      State& checkerState = state();
+      std::lock_guard<std::mutex> lock(checkerState.m_mutex);
+      return checkerState.m_records.size();
+   }
+
+   template <class T>
+   static void allocated(T* i_pointer, bool i_isArray)
+   {
+      if (!i_pointer)
+      {
+         return;
+      }
+
+      State& checkerState = state();
+      const bool sampled = sample(checkerState);
+      if (!sampled && !isCandidate(checkerState, i_pointer))
+      {
+         return;
+      }
+
+      std::lock_guard<std::mutex> lock(checkerState.m_mutex);
+      // The address is handed out again, so whatever was recorded for it is stale.
+      auto found = checkerState.m_records.find(i_pointer);
+      if (found != checkerState.m_records.end())
+      {
+         erase(checkerState, found);
+      }
+      if (sampled)
+      {
+         const Record record = { typeid(T).name(), i_isArray, false };
+         insert(checkerState, i_pointer, record);
+      }
+   }
+
+   template <class TPointer>
+   static void adopted(const TPointer& i_pointer)
+   {
+      adopted(i_pointer, std::is_pointer<TPointer>());
+   }
+
+   template <class TPointer>
+   static void released(const TPointer& i_pointer)
+   {
+      released(i_pointer, std::is_pointer<TPointer>());
+   }
+
+   template <class TPointer>
+   static void forgotten(const TPointer& i_pointer)
+   {
+      forgotten(i_pointer, std::is_pointer<TPointer>());
+   }
+
+   // Called when a UniquePtr takes over another one of a convertible pointer type.
+   template <class TOtherPointer, class TPointer>
+   static void converted(const TOtherPointer& i_from, const TPointer& i_to)
+   {
+      converted(i_from, i_to, std::integral_constant<bool, std::is_pointer<TOtherPointer>::value && std::is_pointer<TPointer>::value>());
+   }
+
+   template <class T>
+   static void deleted(T* i_pointer, bool i_isArray)
+   {
+      State& checkerState = state();
+      if (!isCandidate(checkerState, i_pointer))
+      {
+         return;
+      }
+
+      OwnershipViolation violation = {};
+      {
+         std::lock_guard<std::mutex> lock(checkerState.m_mutex);
+         auto found = checkerState.m_records.find(i_pointer);
+         if (found == checkerState.m_records.end())
+         {
+            return;
+         }
+
+         violation = makeViolation(OwnershipViolationKind::MismatchedDeleter, i_pointer, found->second);
+         const bool mismatched = found->second.m_isArray != i_isArray;
+         erase(checkerState, found);
+         if (!mismatched)
+         {
+            return;
+         }
+      }
+      report(violation);
+   }
+
+private:
+   struct Record
+   {
+      const char* m_typeName;
+      bool m_isArray;
+      bool m_owned;
+   };
+
+   using Records = std::unordered_map<const void*, Record>;
+
+   static const size_t c_filterSize = static_cast<size_t>(1) << UNIQUE_PTR_CHECK_FILTER_BITS;
+
+   struct State
+   {
+      State() : m_samplingRate(UNIQUE_PTR_CHECK_SAMPLING_RATE), m_handler(&ReportToStderr)
+      {
+         for (auto& counter : m_filter)
+         {
+            counter.store(0, std::memory_order_relaxed);
+         }
+      }
+
+      std::atomic<size_t> m_samplingRate;
+      std::atomic<ViolationHandler> m_handler;
+      std::mutex m_mutex;
+      Records m_records;
+      std::atomic<uint32_t> m_filter[c_filterSize];
+   };
+
+   // The state is created on first use and never destroyed, so that UniquePtrs destroyed at exit
+   // are still checked. v120 does not initialize function-local statics thread-safely, the
+   // atomic pointer has no initializer and is zeroed before any code runs.
+   static State& state()
+   {
+      static std::atomic<State*> s_state;
+
+      State* current = s_state.load(std::memory_order_acquire);
+      if (!current)
+      {
+         State* created = new State();
+         if (s_state.compare_exchange_strong(current, created, std::memory_order_acq_rel))
+         {
+            current = created;
+         }
+         else
+         {
+            delete created;
+         }
+      }
+      return *current;
+   }
+
+   // Counts down the allocations of the calling thread to the next sampled one.
+   static bool sample(State& i_state)
+   {
+      static SMART_POINTER_THREAD_LOCAL size_t untilSample = 0;
+
+      const size_t rate = i_state.m_samplingRate.load(std::memory_order_relaxed);
+      if (!rate)
+      {
+         return false;
+      }
+      if (!untilSample || untilSample > rate)
+      {
+         untilSample = rate;
+      }
+      return --untilSample == 0;
+   }
+
+   static std::atomic<uint32_t>& filterCounter(State& i_state, const void* i_pointer)
+   {
+      const uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(i_pointer)) * 0x9e3779b97f4a7c15ull;
+      return i_state.m_filter[static_cast<size_t>(hash >> (64 - UNIQUE_PTR_CHECK_FILTER_BITS))];
+   }
+
+   static bool isCandidate(State& i_state, const void* i_pointer)
+   {
+      return i_pointer && filterCounter(i_state, i_pointer).load(std::memory_order_relaxed) != 0;
+   }
+
+   static void insert(State& i_state, const void* i_pointer, const Record& i_record)
+   {
+      auto inserted = i_state.m_records.insert(std::make_pair(i_pointer, i_record));
+      if (inserted.second)
+      {
+         filterCounter(i_state, i_pointer).fetch_add(1, std::memory_order_relaxed);
+      }
+      else
+      {
+         inserted.first->second = i_record;
+      }
+   }
+
+   static void erase(State& i_state, Records::iterator i_record)
+   {
+      filterCounter(i_state, i_record->first).fetch_sub(1, std::memory_order_relaxed);
+      i_state.m_records.erase(i_record);
+   }
+
+   static OwnershipViolation makeViolation(OwnershipViolationKind i_kind, const void* i_pointer, const Record& i_record)
+   {
+      OwnershipViolation violation = { i_kind, i_pointer, i_record.m_typeName, i_record.m_isArray };
+      return violation;
+   }
+
+   static void report(const OwnershipViolation& i_violation)
+   {
+      state().m_handler.load()(i_violation);
+   }
+
+   static void ReportToStderr(const OwnershipViolation& i_violation)
+   {
+      std::fprintf(stderr, "UniquePtr ownership violation: %s of %s%s at %p\n",
+         i_violation.m_kind == OwnershipViolationKind::DoubleOwnership ? "double ownership" : "mismatched deleter",
+         i_violation.m_typeName, i_violation.m_allocatedAsArray ? "[]" : "", i_violation.m_pointer);
+   }
+
+   template <class TPointer>
+   static void adopted(const TPointer& i_pointer, std::true_type)
+   {
+      State& checkerState = state();
+      if (!isCandidate(checkerState, i_pointer))
+      {
+         return;
+      }
+
+      OwnershipViolation violation = {};
+      {
+         std::lock_guard<std::mutex> lock(checkerState.m_mutex);
+         auto found = checkerState.m_records.find(i_pointer);
+         if (found == checkerState.m_records.end())
+         {
+            return;
+         }
+
+         const bool owned = found->second.m_owned;
+         found->second.m_owned = true;
+         if (!owned)
+         {
+            return;
+         }
+         violation = makeViolation(OwnershipViolationKind::DoubleOwnership, i_pointer, found->second);
+      }
+      report(violation);
+   }
+
+   template <class TPointer>
+   static void released(const TPointer& i_pointer, std::true_type)
+   {
+      forget(i_pointer);
+   }
+
+   // Called after an owned object was passed to its deleter, so that a record of an object
+   // destroyed by a custom deleter does not outlive it.
+   template <class TPointer>
+   static void forgotten(const TPointer& i_pointer, std::true_type)
+   {
+      forget(i_pointer);
+   }
+
+   static void forget(const void* i_pointer)
+   {
+      State& checkerState = state();
+      if (!isCandidate(checkerState, i_pointer))
+      {
+         return;
+      }
+
+      std::lock_guard<std::mutex> lock(checkerState.m_mutex);
+      auto found = checkerState.m_records.find(i_pointer);
+      if (found != checkerState.m_records.end())
+      {
+         erase(checkerState, found);
+      }
+   }
+
+   // A base class subobject may live at another address than the object, the record is moved to
+   // the address it will be deleted through.
+   template <class TOtherPointer, class TPointer>
+   static void converted(const TOtherPointer& i_from, const TPointer& i_to, std::true_type)
+   {
+      State& checkerState = state();
+      if (static_cast<const void*>(i_from) == static_cast<const void*>(i_to) || !isCandidate(checkerState, i_from))
+      {
+         return;
+      }
+
+      std::lock_guard<std::mutex> lock(checkerState.m_mutex);
+      auto found = checkerState.m_records.find(i_from);
+      if (found != checkerState.m_records.end())
+      {
+         const Record record = found->second;
+         erase(checkerState, found);
+         insert(checkerState, i_to, record);
+      }
+   }
+
+   // Pointer types provided by deleters are not checked.
+   template <class TPointer>
+   static void adopted(const TPointer&, std::false_type)
+   {
+   }
+
+   template <class TPointer>
+   static void released(const TPointer&, std::false_type)
+   {
+   }
+
+   template <class TPointer>
+   static void forgotten(const TPointer&, std::false_type)
+   {
+   }
+
+   template <class TOtherPointer, class TPointer>
+   static void converted(const TOtherPointer&, const TPointer&, std::false_type)
+   {
+   }
+};
+
+// The hooks are only instantiated in checked mode, unchecked builds do not see them at all.
+#define UNIQUE_PTR_CHECK(i_hook) OwnershipChecker::i_hook
+
+#else
+
+#define UNIQUE_PTR_CHECK(i_hook)
+
+#endif
+
 template<class T>
 struct DefaultDeleter
 {
@@ -35,6 +427,7 @@ struct DefaultDeleter
 
    void operator()(T* i_ptr) const
    {
+      UNIQUE_PTR_CHECK(deleted(i_ptr, false));
       delete i_ptr;
    }
 };
@@ -48,6 +441,7 @@ struct DefaultDeleter<T[]>
 
    void operator()(T* i_ptr) const
    {
+      UNIQUE_PTR_CHECK(deleted(i_ptr, true));
       delete[] i_ptr;
    }
 
@@ -117,52 +511,64 @@ struct PointerStorage < T, D, true > : public D
 template <class T, class D = DefaultDeleter<T>>
 class UniquePtr : public PointerStorage<T, D, std::is_empty<D>::value>
 {
+   using Storage = PointerStorage<T, D, std::is_empty<D>::value>;
+
 public:
+   using typename Storage::element_type;
+   using typename Storage::pointer;
+   using typename Storage::deleter_type;
+   using Storage::get_deleter;
 
-   UniquePtr() : PointerStorage(nullptr)
+   UniquePtr() : Storage(nullptr)
    {
    }
 
-   UniquePtr(nullptr_t) : PointerStorage(nullptr)
+   UniquePtr(nullptr_t) : Storage(nullptr)
    {
    }
 
-   explicit UniquePtr(pointer i_pointer) : PointerStorage(i_pointer)
+   explicit UniquePtr(pointer i_pointer) : Storage(i_pointer)
    {
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
    }
 
    UniquePtr(pointer i_pointer,
       std::conditional_t<
          std::is_reference<D>::value, D, const D&
-      > i_deleter) : PointerStorage(i_pointer, i_deleter)
+      > i_deleter) : Storage(i_pointer, i_deleter)
    {
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
    }
 
-   UniquePtr(pointer i_pointer, std::remove_reference_t<D>&& i_deleter) : PointerStorage(i_pointer, std::move(i_deleter))
+   UniquePtr(pointer i_pointer, std::remove_reference_t<D>&& i_deleter) : Storage(i_pointer, std::move(i_deleter))
    {
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
    }
 
-   UniquePtr(UniquePtr&& i_other) : PointerStorage(i_other.release(), std::move(i_other.get_deleter()))
+   UniquePtr(UniquePtr&& i_other) : Storage(i_other.m_pointer, std::move(i_other.get_deleter()))
    {
+      i_other.m_pointer = nullptr;
    }
 
    template <class TOtherPtr, class TOtherDeleter,
       class = std::enable_if_t<
          !std::is_array<TOtherPtr>::value &&
-         std::is_convertible<UniquePtr<TOtherPtr, TOtherDeleter>::pointer, pointer>::value &&
+         std::is_convertible<typename UniquePtr<TOtherPtr, TOtherDeleter>::pointer, pointer>::value &&
          ((std::is_reference<D>::value && std::is_same<D, TOtherDeleter>::value) ||
          (!std::is_reference<D>::value && std::is_convertible<TOtherDeleter, D>::value))
       >>
    UniquePtr(UniquePtr<TOtherPtr, TOtherDeleter>&& i_uniquePtrOther) :
-      PointerStorage(i_uniquePtrOther.release(), std::forward<TOtherDeleter>(i_uniquePtrOther.get_deleter()))
+      Storage(i_uniquePtrOther.m_pointer, std::forward<TOtherDeleter>(i_uniquePtrOther.get_deleter()))
    {
+      UNIQUE_PTR_CHECK(converted(i_uniquePtrOther.m_pointer, this->m_pointer));
+      i_uniquePtrOther.m_pointer = nullptr;
    }
 
    UniquePtr& operator=(UniquePtr&& i_uniquePtrOther)
    {
       if (this != &i_uniquePtrOther)
       {
-         reset(i_uniquePtrOther.release());
+         replace(i_uniquePtrOther);
          get_deleter() = std::forward<D>(i_uniquePtrOther.get_deleter());
       }
       return *this;
@@ -171,12 +577,12 @@ public:
    template<class TPointerOther, class TDeleterOther,
       class = std::enable_if_t<
          !std::is_array<TPointerOther>::value &&
-         std::is_convertible<UniquePtr<TPointerOther, TDeleterOther>::pointer, pointer>::value &&
+         std::is_convertible<typename UniquePtr<TPointerOther, TDeleterOther>::pointer, pointer>::value &&
          std::is_assignable<D&, TDeleterOther&&>::value
       >>
    UniquePtr& operator=(UniquePtr<TPointerOther, TDeleterOther>&& i_uniquePtrOther)
    {
-      reset(i_uniquePtrOther.release());
+      replace(i_uniquePtrOther);
       get_deleter() = std::forward<TDeleterOther>(i_uniquePtrOther.get_deleter());
       return *this;
    }
@@ -189,12 +595,14 @@ public:
 
    void reset(pointer i_pointer = nullptr)
    {
-      pointer temp = m_pointer;
-      m_pointer = i_pointer;
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
+      pointer temp = this->m_pointer;
+      this->m_pointer = i_pointer;
 
       if (temp)
       {
          get_deleter()(temp);
+         UNIQUE_PTR_CHECK(forgotten(temp));
       }
    }
 
@@ -205,55 +613,82 @@ public:
 
    pointer get() const
    {
-      return m_pointer;
+      return this->m_pointer;
    }
 
    pointer release()
    {
-      pointer ptr = m_pointer;
-      m_pointer = nullptr;
+      pointer ptr = this->m_pointer;
+      this->m_pointer = nullptr;
+      UNIQUE_PTR_CHECK(released(ptr));
       return ptr;
    }
 
    void swap(UniquePtr& i_other)
    {
-      std::swap(m_pointer, i_other.m_pointer);
+      std::swap(this->m_pointer, i_other.m_pointer);
+      std::swap(get_deleter(), i_other.get_deleter());
    }
 
    pointer operator->() const
    {
-      return m_pointer;
+      return this->m_pointer;
    }
 
    element_type& operator*() const
    {
-      return *m_pointer;
+      return *this->m_pointer;
    }
 
    explicit operator bool() const
    {
-      return m_pointer != nullptr;
+      return this->m_pointer != nullptr;
    }
 
    UniquePtr(const UniquePtr&) = delete;
    UniquePtr& operator = (const UniquePtr&) = delete;
+
+private:
+   // Takes over the pointer of another UniquePtr. Ownership moved between UniquePtrs stays
+   // within the checked family, so unlike reset it skips the adopted hook.
+   template <class TUniquePtr>
+   void replace(TUniquePtr& i_other)
+   {
+      pointer temp = this->m_pointer;
+      this->m_pointer = i_other.m_pointer;
+      UNIQUE_PTR_CHECK(converted(i_other.m_pointer, this->m_pointer));
+      i_other.m_pointer = nullptr;
+
+      if (temp)
+      {
+         get_deleter()(temp);
+         UNIQUE_PTR_CHECK(forgotten(temp));
+      }
+   }
 };
 
 template <class T, class D>
 class UniquePtr<T[], D> : public PointerStorage<T, D, std::is_empty<D>::value>
 {
+   using Storage = PointerStorage<T, D, std::is_empty<D>::value>;
+
 public:
+   using typename Storage::element_type;
+   using typename Storage::pointer;
+   using typename Storage::deleter_type;
+   using Storage::get_deleter;
 
-   UniquePtr() : PointerStorage(nullptr)
+   UniquePtr() : Storage(nullptr)
    {
    }
 
-   UniquePtr(nullptr_t) : PointerStorage(nullptr)
+   UniquePtr(nullptr_t) : Storage(nullptr)
    {
    }
 
-   explicit UniquePtr(pointer i_pointer) : PointerStorage(i_pointer)
+   explicit UniquePtr(pointer i_pointer) : Storage(i_pointer)
    {
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
    }
 
    UniquePtr(pointer i_pointer,
@@ -261,23 +696,26 @@ public:
          std::is_reference<D>::value,
          D,
          const std::remove_reference_t<D>&
-      > i_deleter) : PointerStorage(i_pointer, i_deleter)
+      > i_deleter) : Storage(i_pointer, i_deleter)
    {
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
    }
 
-   UniquePtr(pointer i_pointer, std::remove_reference_t<D>&& i_deleter) : PointerStorage(i_pointer, std::move(i_deleter))
+   UniquePtr(pointer i_pointer, std::remove_reference_t<D>&& i_deleter) : Storage(i_pointer, std::move(i_deleter))
    {
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
    }
 
-   UniquePtr(UniquePtr&& i_other) : PointerStorage(i_other.release(), std::move(i_other.get_deleter()))
+   UniquePtr(UniquePtr&& i_other) : Storage(i_other.m_pointer, std::move(i_other.get_deleter()))
    {
+      i_other.m_pointer = nullptr;
    }
 
    UniquePtr& operator=(UniquePtr&& i_uniquePtrOther)
    {
       if (this != &i_uniquePtrOther)
       {
-         reset(i_uniquePtrOther.release());
+         replace(i_uniquePtrOther);
          get_deleter() = std::forward<D>(i_uniquePtrOther.get_deleter());
       }
       return *this;
@@ -291,12 +729,14 @@ public:
 
    void reset(pointer i_pointer = nullptr)
    {
-      pointer temp = m_pointer;
-      m_pointer = i_pointer;
+      UNIQUE_PTR_CHECK(adopted(i_pointer));
+      pointer temp = this->m_pointer;
+      this->m_pointer = i_pointer;
 
       if (temp)
       {
          get_deleter()(temp);
+         UNIQUE_PTR_CHECK(forgotten(temp));
       }
    }
 
@@ -312,55 +752,76 @@ public:
 
    pointer get() const
    {
-      return m_pointer;
+      return this->m_pointer;
    }
 
    pointer release()
    {
-      pointer ptr = m_pointer;
-      m_pointer = nullptr;
+      pointer ptr = this->m_pointer;
+      this->m_pointer = nullptr;
+      UNIQUE_PTR_CHECK(released(ptr));
       return ptr;
    }
 
    void swap(UniquePtr& i_other)
    {
-      std::swap(m_pointer, i_other.m_pointer);
+      std::swap(this->m_pointer, i_other.m_pointer);
+      std::swap(get_deleter(), i_other.get_deleter());
    }
 
    pointer operator->() const
    {
-      return m_pointer;
+      return this->m_pointer;
    }
 
    element_type& operator*() const
    {
-      return *m_pointer;
+      return *this->m_pointer;
    }
 
    element_type& operator[](size_t i_index) const
    {
-      return m_pointer[i_index];
+      return this->m_pointer[i_index];
    }
 
    explicit operator bool() const
    {
-      return m_pointer != nullptr;
+      return this->m_pointer != nullptr;
    }
 
    UniquePtr(const UniquePtr&) = delete;
    UniquePtr& operator = (const UniquePtr&) = delete;
+
+private:
+   // Takes over the pointer of another UniquePtr without the adopted hook, see the T specialization.
+   void replace(UniquePtr& i_other)
+   {
+      pointer temp = this->m_pointer;
+      this->m_pointer = i_other.m_pointer;
+      i_other.m_pointer = nullptr;
+
+      if (temp)
+      {
+         get_deleter()(temp);
+         UNIQUE_PTR_CHECK(forgotten(temp));
+      }
+   }
 };
 
 template <class T, class... TParams, class = std::enable_if_t<!std::is_array<T>::value>>
 UniquePtr<T> MakeUnique(TParams&&... i_params)
 {
-   return UniquePtr<T>(new T(std::forward<TParams>(i_params)...));
+   T* object = new T(std::forward<TParams>(i_params)...);
+   UNIQUE_PTR_CHECK(allocated(object, false));
+   return UniquePtr<T>(object);
 }
 
 template <class T, class = std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0>>
 UniquePtr<T> MakeUnique(size_t i_size)
 {
-   return UniquePtr<T>(new std::remove_extent_t<T>[i_size]());
+   std::remove_extent_t<T>* array = new std::remove_extent_t<T>[i_size]();
+   UNIQUE_PTR_CHECK(allocated(array, true));
+   return UniquePtr<T>(array);
 }
 
 template <class T, class D>
@@ -430,15 +891,15 @@ bool operator!=(nullptr_t i_lhs, const UniquePtr<T, D>& i_rhs)
 }
 
 template <class T, class D>
-bool operator<(const UniquePtr<T, D>& i_lhs, nullptr_t i_rhs)
+bool operator<(const UniquePtr<T, D>& i_lhs, nullptr_t)
 {
-   return i_lhs.get() < i_rhs;
+   return i_lhs.get() < typename UniquePtr<T, D>::pointer();
 }
 
 template <class T, class D>
-bool operator<(nullptr_t i_lhs, const UniquePtr<T, D>& i_rhs)
+bool operator<(nullptr_t, const UniquePtr<T, D>& i_rhs)
 {
-   return i_lhs < i_rhs.get();
+   return typename UniquePtr<T, D>::pointer() < i_rhs.get();
 }
 
 template <class T, class D>
@@ -475,4 +936,4 @@ template <class T, class D>
 bool operator>=(nullptr_t i_lhs, const UniquePtr<T, D>& i_rhs)
 {
    return !(i_lhs < i_rhs);
-}
\ No newline at end of file
+}
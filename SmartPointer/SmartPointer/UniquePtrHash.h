@@ -0,0 +1,74 @@
+#pragma once
+
+#include "UniquePtr.h"
+
+#include <functional>
+
+template <class T, class D = DefaultDeleter<T>>
+struct UniquePtrKey
+{
+   using pointer = typename UniquePtr<T, D>::pointer;
+
+   static pointer Get(const UniquePtr<T, D>& i_uniquePtr)
+   {
+      return i_uniquePtr.get();
+   }
+
+   static pointer Get(pointer i_pointer)
+   {
+      return i_pointer;
+   }
+};
+
+// Transparent comparators and hasher, let containers keyed by UniquePtr be searched
+// by raw pointer or nullptr without constructing a temporary owning UniquePtr.
+template <class T, class D = DefaultDeleter<T>>
+struct UniquePtrLess
+{
+   using is_transparent = void;
+
+   template <class TLeft, class TRight>
+   bool operator()(const TLeft& i_lhs, const TRight& i_rhs) const
+   {
+      using Key = UniquePtrKey<T, D>;
+      return std::less<typename Key::pointer>()(Key::Get(i_lhs), Key::Get(i_rhs));
+   }
+};
+
+template <class T, class D = DefaultDeleter<T>>
+struct UniquePtrEqualTo
+{
+   using is_transparent = void;
+
+   template <class TLeft, class TRight>
+   bool operator()(const TLeft& i_lhs, const TRight& i_rhs) const
+   {
+      using Key = UniquePtrKey<T, D>;
+      return Key::Get(i_lhs) == Key::Get(i_rhs);
+   }
+};
+
+template <class T, class D = DefaultDeleter<T>>
+struct UniquePtrHash
+{
+   using is_transparent = void;
+
+   template <class TKey>
+   size_t operator()(const TKey& i_key) const
+   {
+      using Key = UniquePtrKey<T, D>;
+      return std::hash<typename Key::pointer>()(Key::Get(i_key));
+   }
+};
+
+namespace std
+{
+   template <class T, class D>
+   struct hash<UniquePtr<T, D>>
+   {
+      size_t operator()(const UniquePtr<T, D>& i_uniquePtr) const
+      {
+         return hash<typename UniquePtr<T, D>::pointer>()(i_uniquePtr.get());
+      }
+   };
+}
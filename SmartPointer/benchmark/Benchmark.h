@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+template <class TFunction>
+double MeasureSeconds(TFunction&& i_function)
+{
+   const auto start = std::chrono::high_resolution_clock::now();
+   i_function();
+   return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+inline void ReportBenchmark(const char* i_name, size_t i_operations, double i_seconds)
+{
+   std::printf("%-64s %10.1f ns/op\n", i_name, i_seconds * 1e9 / i_operations);
+}
+
+// Restricts the calling thread to the given core.
+void PinCurrentThread(unsigned i_core);
+
+// Keeps results of benchmarked operations alive so that the optimizer can not drop them.
+extern volatile size_t g_benchmarkSink;
+
+void RunBudgetBenchmarks();
+void RunChannelBenchmarks();
+void RunIntrusivePtrBenchmarks();
+void RunLookupBenchmarks();
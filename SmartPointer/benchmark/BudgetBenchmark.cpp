@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+#include "Budget.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Charges and refunds from several threads at once, against a budget far from its limits.
+// The baseline is a single shared counter charged with fetch_add and refunded on failure,
+// which every charge of every thread writes to.
+
+namespace
+{
+   const size_t c_chargesCount = 1 << 22;
+   const size_t c_chargeSize = 48;
+
+   class SharedCounterBudget
+   {
+   public:
+      explicit SharedCounterBudget(size_t i_hardLimit) : m_hardLimit(i_hardLimit), m_used(0)
+      {
+      }
+
+      bool charge(size_t i_bytes)
+      {
+         if (m_used.fetch_add(i_bytes, std::memory_order_relaxed) + i_bytes > m_hardLimit)
+         {
+            refund(i_bytes);
+            return false;
+         }
+         return true;
+      }
+
+      void refund(size_t i_bytes)
+      {
+         m_used.fetch_sub(i_bytes, std::memory_order_relaxed);
+      }
+
+   private:
+      const size_t m_hardLimit;
+      std::atomic<size_t> m_used;
+   };
+
+   template <class TBudget>
+   void BenchmarkCharges(const char* i_name, TBudget& i_budget, unsigned i_threadsCount)
+   {
+      const size_t chargesPerThread = c_chargesCount / i_threadsCount;
+      const double seconds = MeasureSeconds([&]()
+      {
+         std::vector<std::thread> threads;
+         for (unsigned i = 0; i < i_threadsCount; ++i)
+         {
+            threads.emplace_back([&]()
+            {
+               // A few objects are kept alive at a time, as in an allocation-heavy subsystem.
+               for (size_t j = 0; j < chargesPerThread; j += 4)
+               {
+                  for (size_t k = 0; k < 4; ++k)
+                  {
+                     g_benchmarkSink += i_budget.charge(c_chargeSize);
+                  }
+                  i_budget.refund(4 * c_chargeSize);
+               }
+            });
+         }
+         for (auto& thread : threads)
+         {
+            thread.join();
+         }
+      });
+
+      const std::string name = std::string(i_name) + ", " + std::to_string(i_threadsCount) + " threads";
+      ReportBenchmark(name.c_str(), chargesPerThread * i_threadsCount, seconds);
+   }
+}
+
+void RunBudgetBenchmarks()
+{
+   std::printf("Budget charges of %u bytes:\n", static_cast<unsigned>(c_chargeSize));
+   const unsigned maxThreadsCount = std::max(1u, std::thread::hardware_concurrency());
+   for (unsigned threadsCount = 1; threadsCount <= maxThreadsCount; threadsCount *= 2)
+   {
+      SharedCounterBudget sharedCounter(static_cast<size_t>(1) << 30);
+      BenchmarkCharges("shared counter", sharedCounter, threadsCount);
+
+      Budget budget("benchmark", static_cast<size_t>(1) << 29, static_cast<size_t>(1) << 30);
+      BenchmarkCharges("Budget with per-thread slack", budget, threadsCount);
+   }
+}
@@ -0,0 +1,189 @@
+#include "Benchmark.h"
+#include "Channel.h"
+
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput and round trip latency of the channels against a mutex protected std::queue,
+// with the threads pinned to pairs of cores. Items point into a preallocated array and are
+// never deleted, so that only the hand-over is measured.
+
+namespace
+{
+   const size_t c_channelCapacity = 1024;
+   const size_t c_itemsCount = 1 << 21;
+   const size_t c_roundTripsCount = 1 << 16;
+
+   struct NoDelete
+   {
+      void operator()(int*) const
+      {
+      }
+   };
+
+   using Item = UniquePtr<int, NoDelete>;
+
+   class MutexQueue
+   {
+   public:
+      explicit MutexQueue(size_t i_capacity) : m_capacity(i_capacity)
+      {
+      }
+
+      bool push(Item&& i_item)
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_queue.size() == m_capacity)
+         {
+            return false;
+         }
+         m_queue.push(std::move(i_item));
+         return true;
+      }
+
+      Item tryPop()
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_queue.empty())
+         {
+            return Item();
+         }
+         Item item = std::move(m_queue.front());
+         m_queue.pop();
+         return item;
+      }
+
+   private:
+      const size_t m_capacity;
+      std::mutex m_mutex;
+      std::queue<Item> m_queue;
+   };
+
+   template <class TQueue>
+   void Push(TQueue& i_queue, int* i_item)
+   {
+      Item item(i_item);
+      while (!i_queue.push(std::move(item)))
+      {
+         std::this_thread::yield();
+      }
+   }
+
+   template <class TQueue>
+   int* Pop(TQueue& i_queue)
+   {
+      for (;;)
+      {
+         if (Item item = i_queue.tryPop())
+         {
+            return item.release();
+         }
+         std::this_thread::yield();
+      }
+   }
+
+   // Every producer pushes its share of the items, the consumer pops all of them.
+   template <class TQueue>
+   void BenchmarkThroughput(const char* i_name, const std::vector<unsigned>& i_producerCores, unsigned i_consumerCore)
+   {
+      TQueue queue(c_channelCapacity);
+      std::vector<int> items(c_itemsCount);
+      const size_t itemsPerProducer = c_itemsCount / i_producerCores.size();
+
+      const double seconds = MeasureSeconds([&]()
+      {
+         std::vector<std::thread> producers;
+         for (size_t i = 0; i < i_producerCores.size(); ++i)
+         {
+            producers.emplace_back([&, i]()
+            {
+               PinCurrentThread(i_producerCores[i]);
+               for (size_t j = 0; j < itemsPerProducer; ++j)
+               {
+                  Push(queue, &items[i * itemsPerProducer + j]);
+               }
+            });
+         }
+
+         PinCurrentThread(i_consumerCore);
+         for (size_t j = 0; j < itemsPerProducer * i_producerCores.size(); ++j)
+         {
+            g_benchmarkSink += *Pop(queue);
+         }
+         for (auto& producer : producers)
+         {
+            producer.join();
+         }
+      });
+
+      const std::string name = std::string(i_name) + ", " + std::to_string(i_producerCores.size()) + " producer(s) -> core " + std::to_string(i_consumerCore);
+      ReportBenchmark(name.c_str(), itemsPerProducer * i_producerCores.size(), seconds);
+   }
+
+   // One item bounces between two threads over a pair of queues, reported per round trip.
+   template <class TQueue>
+   void BenchmarkRoundTrip(const char* i_name, unsigned i_firstCore, unsigned i_secondCore)
+   {
+      TQueue request(c_channelCapacity);
+      TQueue response(c_channelCapacity);
+      int item = 0;
+
+      const double seconds = MeasureSeconds([&]()
+      {
+         std::thread echo([&]()
+         {
+            PinCurrentThread(i_secondCore);
+            for (size_t i = 0; i < c_roundTripsCount; ++i)
+            {
+               Push(response, Pop(request));
+            }
+         });
+
+         PinCurrentThread(i_firstCore);
+         for (size_t i = 0; i < c_roundTripsCount; ++i)
+         {
+            Push(request, &item);
+            g_benchmarkSink += *Pop(response);
+         }
+         echo.join();
+      });
+
+      const std::string name = std::string(i_name) + " round trip, cores " + std::to_string(i_firstCore) + "-" + std::to_string(i_secondCore);
+      ReportBenchmark(name.c_str(), c_roundTripsCount, seconds);
+   }
+}
+
+void RunChannelBenchmarks()
+{
+   const unsigned coresCount = std::max(1u, std::thread::hardware_concurrency());
+   std::printf("Channels, capacity %u, %u cores:\n", static_cast<unsigned>(c_channelCapacity), coresCount);
+
+   // Core 0 paired with every other core, and with itself when there is no other.
+   for (unsigned core = coresCount > 1 ? 1 : 0; core < coresCount; ++core)
+   {
+      const std::vector<unsigned> producerCores(1, core);
+      BenchmarkThroughput<SpscChannel<int, NoDelete>>("SpscChannel", producerCores, 0);
+      BenchmarkThroughput<MpscChannel<int, NoDelete>>("MpscChannel", producerCores, 0);
+      BenchmarkThroughput<MutexQueue>("mutex std::queue", producerCores, 0);
+
+      BenchmarkRoundTrip<SpscChannel<int, NoDelete>>("SpscChannel", 0, core);
+      BenchmarkRoundTrip<MpscChannel<int, NoDelete>>("MpscChannel", 0, core);
+      BenchmarkRoundTrip<MutexQueue>("mutex std::queue", 0, core);
+   }
+
+   // All the other cores producing into core 0.
+   std::vector<unsigned> producerCores;
+   for (unsigned core = 1; core < coresCount; ++core)
+   {
+      producerCores.push_back(core);
+   }
+   if (producerCores.size() > 1)
+   {
+      BenchmarkThroughput<MpscChannel<int, NoDelete>>("MpscChannel", producerCores, 0);
+      BenchmarkThroughput<MutexQueue>("mutex std::queue", producerCores, 0);
+   }
+}
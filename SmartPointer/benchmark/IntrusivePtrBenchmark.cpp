@@ -0,0 +1,134 @@
+#include "Benchmark.h"
+#include "IntrusivePtr.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reference count heavy workloads with IntrusivePtr under both count policies against
+// std::shared_ptr created with make_shared.
+
+namespace
+{
+   const size_t c_objectsCount = 1 << 16;
+   const size_t c_copiesCount = 1 << 23;
+
+   template <class TCountPolicy>
+   struct IntrusiveObject : public RefCounted<TCountPolicy>
+   {
+      int m_value;
+   };
+
+   struct SharedObject
+   {
+      int m_value;
+   };
+
+   template <class TCountPolicy>
+   IntrusivePtr<IntrusiveObject<TCountPolicy>, TCountPolicy> Create(IntrusivePtr<IntrusiveObject<TCountPolicy>, TCountPolicy>*)
+   {
+      return IntrusivePtr<IntrusiveObject<TCountPolicy>, TCountPolicy>(MakeUnique<IntrusiveObject<TCountPolicy>>());
+   }
+
+   std::shared_ptr<SharedObject> Create(std::shared_ptr<SharedObject>*)
+   {
+      return std::make_shared<SharedObject>();
+   }
+
+   template <class THandle>
+   void BenchmarkCreation(const char* i_name)
+   {
+      std::vector<THandle> handles(c_objectsCount);
+      const double seconds = MeasureSeconds([&]()
+      {
+         for (auto& handle : handles)
+         {
+            handle = Create(static_cast<THandle*>(nullptr));
+         }
+         handles.clear();
+      });
+
+      const std::string name = std::string(i_name) + ", create and destroy";
+      ReportBenchmark(name.c_str(), c_objectsCount, seconds);
+   }
+
+   // Copies handles of objects scattered over a working set, as a graph traversal does.
+   template <class THandle>
+   void BenchmarkCopies(const char* i_name)
+   {
+      std::vector<THandle> objects;
+      for (size_t i = 0; i < c_objectsCount; ++i)
+      {
+         objects.push_back(Create(static_cast<THandle*>(nullptr)));
+      }
+
+      const double seconds = MeasureSeconds([&]()
+      {
+         size_t index = 0;
+         for (size_t i = 0; i < c_copiesCount; ++i)
+         {
+            index = (index + 7919) % c_objectsCount;
+            THandle copy = objects[index];
+            g_benchmarkSink += copy->m_value;
+         }
+      });
+
+      const std::string name = std::string(i_name) + ", copy and destroy (handle " + std::to_string(sizeof(THandle)) + " bytes)";
+      ReportBenchmark(name.c_str(), c_copiesCount, seconds);
+   }
+
+   // All threads copy handles of the same object, so they contend for one counter.
+   template <class THandle>
+   void BenchmarkSharedCopies(const char* i_name, unsigned i_threadsCount)
+   {
+      const THandle object = Create(static_cast<THandle*>(nullptr));
+      const size_t copiesPerThread = c_copiesCount / i_threadsCount;
+
+      const double seconds = MeasureSeconds([&]()
+      {
+         std::vector<std::thread> threads;
+         for (unsigned i = 0; i < i_threadsCount; ++i)
+         {
+            threads.emplace_back([&]()
+            {
+               for (size_t j = 0; j < copiesPerThread; ++j)
+               {
+                  THandle copy = object;
+                  g_benchmarkSink += copy->m_value;
+               }
+            });
+         }
+         for (auto& thread : threads)
+         {
+            thread.join();
+         }
+      });
+
+      const std::string name = std::string(i_name) + ", contended copies, " + std::to_string(i_threadsCount) + " threads";
+      ReportBenchmark(name.c_str(), copiesPerThread * i_threadsCount, seconds);
+   }
+}
+
+void RunIntrusivePtrBenchmarks()
+{
+   using AtomicIntrusivePtr = IntrusivePtr<IntrusiveObject<AtomicCountPolicy>, AtomicCountPolicy>;
+   using PlainIntrusivePtr = IntrusivePtr<IntrusiveObject<PlainCountPolicy>, PlainCountPolicy>;
+   using SharedPtrHandle = std::shared_ptr<SharedObject>;
+
+   std::printf("Reference counting, %u objects:\n", static_cast<unsigned>(c_objectsCount));
+   BenchmarkCreation<SharedPtrHandle>("std::shared_ptr");
+   BenchmarkCreation<AtomicIntrusivePtr>("IntrusivePtr, atomic count");
+   BenchmarkCreation<PlainIntrusivePtr>("IntrusivePtr, plain count");
+
+   BenchmarkCopies<SharedPtrHandle>("std::shared_ptr");
+   BenchmarkCopies<AtomicIntrusivePtr>("IntrusivePtr, atomic count");
+   BenchmarkCopies<PlainIntrusivePtr>("IntrusivePtr, plain count");
+
+   const unsigned maxThreadsCount = std::max(1u, std::thread::hardware_concurrency());
+   for (unsigned threadsCount = 2; threadsCount <= maxThreadsCount; threadsCount *= 2)
+   {
+      BenchmarkSharedCopies<SharedPtrHandle>("std::shared_ptr", threadsCount);
+      BenchmarkSharedCopies<AtomicIntrusivePtr>("IntrusivePtr, atomic count", threadsCount);
+   }
+}
@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+#include "UniquePtrHash.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+// Lookups by raw pointer in registries owning their entries through UniquePtr. The baseline is
+// the pattern the transparent comparators replace: wrapping the raw pointer into a temporary
+// owning UniquePtr for the lookup and releasing it afterwards.
+
+namespace
+{
+   const size_t c_entriesCount = 1 << 21;
+   const size_t c_lookupsCount = 1 << 22;
+
+   std::vector<int*> MakeLookups(const std::vector<int*>& i_entries)
+   {
+      std::mt19937 random(42);
+      std::uniform_int_distribution<size_t> index(0, i_entries.size() - 1);
+      std::vector<int*> lookups(c_lookupsCount);
+      for (auto& lookup : lookups)
+      {
+         lookup = i_entries[index(random)];
+      }
+      return lookups;
+   }
+
+   template <class TRegistry>
+   void FillRegistry(TRegistry& o_registry, std::vector<int*>& o_entries)
+   {
+      for (size_t i = 0; i < c_entriesCount; ++i)
+      {
+         UniquePtr<int> entry(new int(static_cast<int>(i)));
+         o_entries.push_back(entry.get());
+         o_registry.insert(std::move(entry));
+      }
+   }
+
+   template <class TRegistry>
+   void BenchmarkTemporaryLookup(const char* i_name)
+   {
+      TRegistry registry;
+      std::vector<int*> entries;
+      FillRegistry(registry, entries);
+      const auto lookups = MakeLookups(entries);
+
+      const double seconds = MeasureSeconds([&]()
+      {
+         for (int* lookup : lookups)
+         {
+            UniquePtr<int> key(lookup);
+            g_benchmarkSink += registry.count(key);
+            key.release();
+         }
+      });
+      ReportBenchmark(i_name, lookups.size(), seconds);
+   }
+
+   template <class TRegistry>
+   void BenchmarkTransparentLookup(const char* i_name)
+   {
+      TRegistry registry;
+      std::vector<int*> entries;
+      FillRegistry(registry, entries);
+      const auto lookups = MakeLookups(entries);
+
+      const double seconds = MeasureSeconds([&]()
+      {
+         for (int* lookup : lookups)
+         {
+            g_benchmarkSink += registry.find(lookup) != registry.end();
+         }
+      });
+      ReportBenchmark(i_name, lookups.size(), seconds);
+   }
+}
+
+void RunLookupBenchmarks()
+{
+   std::printf("Registry lookups, %u entries:\n", static_cast<unsigned>(c_entriesCount));
+   BenchmarkTemporaryLookup<std::set<UniquePtr<int>>>("set, temporary UniquePtr key");
+   BenchmarkTransparentLookup<std::set<UniquePtr<int>, UniquePtrLess<int>>>("set, UniquePtrLess by raw pointer");
+   BenchmarkTemporaryLookup<std::unordered_set<UniquePtr<int>>>("unordered_set, temporary UniquePtr key");
+#if defined(__cpp_lib_generic_unordered_lookup)
+   BenchmarkTransparentLookup<std::unordered_set<UniquePtr<int>, UniquePtrHash<int>, UniquePtrEqualTo<int>>>("unordered_set, UniquePtrHash by raw pointer");
+#endif
+}
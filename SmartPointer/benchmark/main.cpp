@@ -0,0 +1,30 @@
+#include "Benchmark.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+volatile size_t g_benchmarkSink = 0;
+
+void PinCurrentThread(unsigned i_core)
+{
+#ifdef _WIN32
+   SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << i_core);
+#else
+   cpu_set_t cores;
+   CPU_ZERO(&cores);
+   CPU_SET(i_core, &cores);
+   pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+#endif
+}
+
+int main()
+{
+   RunLookupBenchmarks();
+   RunBudgetBenchmarks();
+   RunChannelBenchmarks();
+   RunIntrusivePtrBenchmarks();
+   return 0;
+}
@@ -0,0 +1,48 @@
+#include "UniquePtr.h"
+
+// Instantiates UniquePtr for thousands of distinct types, each used the way ordinary code
+// uses it: created, moved, reset, compared, and once as an array. The build of this file
+// reports the compiler front-end time and the object size, see compilebenchmark.vcxproj.
+
+int g_compileBenchmarkSink = 0;
+
+#define COMPILE_BENCHMARK_TYPE(n) \
+   struct S##n \
+   { \
+      int m_value; \
+   }; \
+   \
+   void Use##n() \
+   { \
+      UniquePtr<S##n> single = MakeUnique<S##n>(); \
+      UniquePtr<S##n> moved = std::move(single); \
+      moved->m_value = n; \
+      UniquePtr<S##n[]> array = MakeUnique<S##n[]>(2); \
+      array[1].m_value = moved->m_value; \
+      g_compileBenchmarkSink += (single == nullptr) + (moved != single) + (single < moved); \
+      g_compileBenchmarkSink += (array != nullptr) + array[1].m_value; \
+      moved.reset(single.release()); \
+   }
+
+#define COMPILE_BENCHMARK_TYPES_10(n) \
+   COMPILE_BENCHMARK_TYPE(n##0) COMPILE_BENCHMARK_TYPE(n##1) COMPILE_BENCHMARK_TYPE(n##2) \
+   COMPILE_BENCHMARK_TYPE(n##3) COMPILE_BENCHMARK_TYPE(n##4) COMPILE_BENCHMARK_TYPE(n##5) \
+   COMPILE_BENCHMARK_TYPE(n##6) COMPILE_BENCHMARK_TYPE(n##7) COMPILE_BENCHMARK_TYPE(n##8) \
+   COMPILE_BENCHMARK_TYPE(n##9)
+
+#define COMPILE_BENCHMARK_TYPES_100(n) \
+   COMPILE_BENCHMARK_TYPES_10(n##0) COMPILE_BENCHMARK_TYPES_10(n##1) COMPILE_BENCHMARK_TYPES_10(n##2) \
+   COMPILE_BENCHMARK_TYPES_10(n##3) COMPILE_BENCHMARK_TYPES_10(n##4) COMPILE_BENCHMARK_TYPES_10(n##5) \
+   COMPILE_BENCHMARK_TYPES_10(n##6) COMPILE_BENCHMARK_TYPES_10(n##7) COMPILE_BENCHMARK_TYPES_10(n##8) \
+   COMPILE_BENCHMARK_TYPES_10(n##9)
+
+#define COMPILE_BENCHMARK_TYPES_1000(n) \
+   COMPILE_BENCHMARK_TYPES_100(n##0) COMPILE_BENCHMARK_TYPES_100(n##1) COMPILE_BENCHMARK_TYPES_100(n##2) \
+   COMPILE_BENCHMARK_TYPES_100(n##3) COMPILE_BENCHMARK_TYPES_100(n##4) COMPILE_BENCHMARK_TYPES_100(n##5) \
+   COMPILE_BENCHMARK_TYPES_100(n##6) COMPILE_BENCHMARK_TYPES_100(n##7) COMPILE_BENCHMARK_TYPES_100(n##8) \
+   COMPILE_BENCHMARK_TYPES_100(n##9)
+
+COMPILE_BENCHMARK_TYPES_1000(1)
+COMPILE_BENCHMARK_TYPES_1000(2)
+COMPILE_BENCHMARK_TYPES_1000(3)
+COMPILE_BENCHMARK_TYPES_1000(4)
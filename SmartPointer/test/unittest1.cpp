@@ -1,8 +1,24 @@
 #include "stdafx.h"
 #include "CppUnitTest.h"
 #include "UniquePtr.h"
-
+#include "UniquePtrHash.h"
+#include "Budget.h"
+#include "Channel.h"
+#include "GrowableArray.h"
+#include "IntrusivePtr.h"
+#include "SharedPtr.h"
+#include "Slab.h"
+#include "Snapshot.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <thread>
 #include <type_traits>
+#include <unordered_set>
+#include <vector>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -51,13 +67,135 @@ namespace
       using pointer = int*;
    };
 
+   struct TreeNode
+   {
+      explicit TreeNode(int i_value) : m_value(i_value)
+      {
+      }
+
+      template <class TVisitor>
+      void forEachChild(TVisitor&& i_visitor) const
+      {
+         i_visitor(m_left);
+         i_visitor(m_right);
+      }
+
+      int m_value;
+      SlabUniquePtr<TreeNode> m_left;
+      SlabUniquePtr<TreeNode> m_right;
+   };
+
+   // Snapshot file written by the constructor and removed once the restored tree, declared after
+   // it, is destroyed and no longer maps it.
+   struct SnapshotFile
+   {
+      SnapshotFile(const char* i_path, const SlabUniquePtr<TreeNode>& i_root) : m_path(i_path)
+      {
+         std::ofstream file(i_path, std::ios::binary | std::ios::trunc);
+         WriteSnapshot(i_root, file);
+      }
+
+      ~SnapshotFile()
+      {
+         std::remove(m_path);
+      }
+
+      const char* m_path;
+   };
+
+   template <class TCountPolicy>
+   struct RefCountedDummy : public RefCounted<TCountPolicy>
+   {
+      RefCountedDummy(bool& i_destructorCalled) : m_destructorCalled(i_destructorCalled)
+      {
+      }
+      ~RefCountedDummy()
+      {
+         m_destructorCalled = true;
+      }
+
+      bool& m_destructorCalled;
+   };
+
+#ifdef UNIQUE_PTR_CHECKED
+   struct FirstBase
+   {
+      virtual ~FirstBase(){}
+      int m_first;
+   };
+   struct SecondBase
+   {
+      virtual ~SecondBase(){}
+      int m_second;
+   };
+   struct DerivedFromBoth : public FirstBase, public SecondBase
+   {
+   };
+
+   // Allocated and freed the same way as a single object and as an array, so that a mismatched
+   // delete expression can be run without corrupting the heap.
+   struct MismatchTolerant
+   {
+      static void* operator new(size_t i_size)
+      {
+         return ::operator new(i_size);
+      }
+
+      static void* operator new[](size_t i_size)
+      {
+         return ::operator new(i_size);
+      }
+
+      static void operator delete(void* i_ptr)
+      {
+         ::operator delete(i_ptr);
+      }
+
+      static void operator delete[](void* i_ptr)
+      {
+         ::operator delete(i_ptr);
+      }
+
+      int m_value;
+   };
+
+   struct ViolationRecorder
+   {
+      ViolationRecorder()
+      {
+         m_violationsCount = 0;
+         OwnershipChecker::setSamplingRate(1);
+         m_previousHandler = OwnershipChecker::setViolationHandler(&Record);
+      }
+
+      ~ViolationRecorder()
+      {
+         OwnershipChecker::setViolationHandler(m_previousHandler);
+         OwnershipChecker::setSamplingRate(UNIQUE_PTR_CHECK_SAMPLING_RATE);
+      }
+
+      static void Record(const OwnershipViolation& i_violation)
+      {
+         m_lastViolation = i_violation;
+         ++m_violationsCount;
+      }
+
+      OwnershipChecker::ViolationHandler m_previousHandler;
+      static OwnershipViolation m_lastViolation;
+      static int m_violationsCount;
+   };
+   OwnershipViolation ViolationRecorder::m_lastViolation;
+   int ViolationRecorder::m_violationsCount = 0;
+#endif
+
    template<class T>
    T* Get(const UniquePtr<T>& i_unique)
    {
       return i_unique.get();
    }
 
-   nullptr_t Get(nullptr_t)
+   // A typed null, nullptr_t itself has no ordering against pointers.
+   int* Get(nullptr_t)
    {
       return nullptr;
    }
@@ -358,5 +496,728 @@ namespace test
          using uniquePtrType = UniquePtr < uniquePtrElemType, DeleterWithoutPointer>;
          Assert::IsTrue(std::is_same<uniquePtrType::pointer, uniquePtrElemType*>::value);
       }
+
+      TEST_METHOD(TestMakeUniqueBatchAllocatesContiguousObjects)
+      {
+         using BoolInt = std::pair < bool, int > ;
+         const bool testBool = true;
+         const int testInt = 42;
+
+         auto batch = MakeUniqueBatch<BoolInt>(4, testBool, testInt);
+
+         Assert::AreEqual(size_t(4), batch.size());
+         for (size_t i = 0; i < batch.size(); ++i)
+         {
+            Assert::AreEqual(batch[i]->first, testBool);
+            Assert::AreEqual(batch[i]->second, testInt);
+            Assert::IsTrue(batch[i].get() == batch[0].get() + i, L"Objects are not allocated contiguously.");
+         }
+      }
+
+      TEST_METHOD(TestMakeUniqueBatchObjectsAreDestroyedIndividually)
+      {
+         auto batch = MakeUniqueBatch<DestructorCallCounter>(3);
+         SlabUniquePtr<DestructorCallCounter> moved = std::move(batch[1]);
+
+         batch[0].reset();
+         Assert::AreEqual(1, DestructorCallCounter::m_destructorCallsCount);
+
+         batch.clear();
+         Assert::AreEqual(2, DestructorCallCounter::m_destructorCallsCount);
+
+         moved.reset();
+         Assert::AreEqual(3, DestructorCallCounter::m_destructorCallsCount);
+      }
+
+      TEST_METHOD(TestMakeUniqueBatchSupportInheritedObjects)
+      {
+         bool wasDestructorCalled = false;
+
+         {
+            auto batch = MakeUniqueBatch<DummyWithDestructor>(2, std::ref(wasDestructorCalled));
+            SlabUniquePtr<Dummy> base = std::move(batch[0]);
+         }
+
+         Assert::IsTrue(wasDestructorCalled);
+      }
+
+      TEST_METHOD(TestMakeUniqueBatchObjectCanBeReplacedWithHeapObject)
+      {
+         auto batch = MakeUniqueBatch<int>(2, 7);
+         auto other = MakeUniqueBatch<int>(1, 8);
+
+         batch[0].reset(new int(1));
+         batch[0].reset();
+         batch[0].swap(other[0]);
+         other.clear();
+         Assert::AreEqual(8, *batch[0]);
+
+         batch[0].reset(new int(2));
+         Assert::AreEqual(2, *batch[0]);
+         Assert::AreEqual(7, *batch[1]);
+      }
+
+      TEST_METHOD(TestHashMatchesStoredPointerHash)
+      {
+         UniquePtr<int> unique(new int);
+         UniquePtr<int> uniqueEmpty;
+
+         Assert::AreEqual(std::hash<int*>()(unique.get()), std::hash<UniquePtr<int>>()(unique));
+         Assert::AreEqual(std::hash<int*>()(nullptr), std::hash<UniquePtr<int>>()(uniqueEmpty));
+         Assert::AreEqual(std::hash<int*>()(unique.get()), UniquePtrHash<int>()(unique.get()));
+      }
+
+      TEST_METHOD(TestSetLookupByRawPointer)
+      {
+         int* ptr = new int;
+         std::set<UniquePtr<int>, UniquePtrLess<int>> set;
+         set.insert(UniquePtr<int>(ptr));
+         set.insert(UniquePtr<int>(new int));
+
+         Assert::IsTrue(set.find(ptr) != set.end(), L"Stored pointer was not found.");
+         Assert::IsTrue(set.find(ptr)->get() == ptr, L"Wrong element was found.");
+         Assert::IsTrue(set.find(nullptr) == set.end(), L"Null pointer was found.");
+         Assert::AreEqual(size_t(1), set.count(ptr));
+      }
+
+      TEST_METHOD(TestUnorderedSetLookupByRawPointer)
+      {
+         int* ptr = new int;
+         std::unordered_set<UniquePtr<int>, UniquePtrHash<int>, UniquePtrEqualTo<int>> set;
+         set.insert(UniquePtr<int>(ptr));
+
+#if defined(__cpp_lib_generic_unordered_lookup)
+         Assert::IsTrue(set.find(ptr) == set.begin());
+         Assert::IsTrue(set.find(nullptr) == set.end());
+#else
+         // Heterogeneous lookup in unordered containers needs C++20, the library only gets
+         // the functors.
+         Assert::AreEqual(UniquePtrHash<int>()(*set.begin()), UniquePtrHash<int>()(ptr));
+         Assert::IsTrue(UniquePtrEqualTo<int>()(*set.begin(), ptr));
+         Assert::IsFalse(UniquePtrEqualTo<int>()(nullptr, *set.begin()));
+#endif
+      }
+
+      TEST_METHOD(TestMakeUniqueGrowableIsZeroFilled)
+      {
+         auto unique = MakeUniqueGrowable<int[]>(3);
+
+         Assert::AreEqual(0, unique[0]);
+         Assert::AreEqual(0, unique[2]);
+         Assert::AreEqual(sizeof(int*), sizeof(unique));
+      }
+
+      TEST_METHOD(TestResizeUniqueKeepsElements)
+      {
+         auto unique = MakeUniqueGrowable<int[]>(2);
+         unique[0] = 70;
+         unique[1] = 2;
+
+         ResizeUnique(unique, 1 << 20);
+         unique[(1 << 20) - 1] = 5;
+
+         Assert::AreEqual(70, unique[0]);
+         Assert::AreEqual(2, unique[1]);
+         Assert::AreEqual(5, unique[(1 << 20) - 1]);
+
+         ResizeUnique(unique, 1);
+
+         Assert::AreEqual(70, unique[0]);
+      }
+
+      TEST_METHOD(TestResizeUniqueToZeroReleasesArray)
+      {
+         auto unique = MakeUniqueGrowable<int[]>(2);
+
+         ResizeUnique(unique, 0);
+
+         Assert::IsNull(unique.get());
+      }
+
+      TEST_METHOD(TestResizeUniqueZeroFillsGrownElements)
+      {
+         auto unique = MakeUniqueGrowable<int[]>(2);
+         unique[1] = 2;
+
+         ResizeUnique(unique, 3);
+         Assert::AreEqual(0, unique[2]);
+
+         ResizeUnique(unique, 1 << 20);
+         Assert::AreEqual(2, unique[1]);
+         Assert::AreEqual(0, unique[3]);
+         Assert::AreEqual(0, unique[(1 << 20) - 1]);
+      }
+
+      TEST_METHOD(TestResizeUniqueZeroFillsElementsRegrownAfterShrinking)
+      {
+         auto unique = MakeUniqueGrowable<int[]>(1 << 20);
+         unique[1000] = 1;
+         unique[1001] = 2;
+         unique[100000] = 3;
+
+         ResizeUnique(unique, 1001);
+         ResizeUnique(unique, 1 << 20);
+
+         Assert::AreEqual(1, unique[1000]);
+         Assert::AreEqual(0, unique[1001]);
+         Assert::AreEqual(0, unique[100000]);
+      }
+
+      TEST_METHOD(TestSnapshotRestoresTree)
+      {
+         SlabUniquePtr<TreeNode> root(new TreeNode(1));
+         root->m_left.reset(new TreeNode(2));
+         root->m_right.reset(new TreeNode(3));
+         root->m_right->m_left.reset(new TreeNode(4));
+
+         SnapshotFile file("TestSnapshotRestoresTree.snapshot", root);
+         auto restored = ReadSnapshot<TreeNode>(file.m_path);
+
+         Assert::AreEqual(1, restored->m_value);
+         Assert::AreEqual(2, restored->m_left->m_value);
+         Assert::AreEqual(3, restored->m_right->m_value);
+         Assert::AreEqual(4, restored->m_right->m_left->m_value);
+         Assert::IsNull(restored->m_left->m_left.get());
+         Assert::IsNull(restored->m_right->m_right.get());
+      }
+
+      TEST_METHOD(TestRestoredTreeCanBeModified)
+      {
+         SlabUniquePtr<TreeNode> root(new TreeNode(1));
+         root->m_left.reset(new TreeNode(2));
+
+         SnapshotFile file("TestRestoredTreeCanBeModified.snapshot", root);
+         auto restored = ReadSnapshot<TreeNode>(file.m_path);
+
+         SlabUniquePtr<TreeNode> detached = std::move(restored->m_left);
+         restored->m_right.reset(new TreeNode(3));
+         restored.reset();
+
+         Assert::AreEqual(2, detached->m_value);
+      }
+
+      TEST_METHOD(TestRestoredChildCanBeReplacedWithHeapNode)
+      {
+         SlabUniquePtr<TreeNode> root(new TreeNode(1));
+         root->m_left.reset(new TreeNode(2));
+         root->m_right.reset(new TreeNode(3));
+
+         SnapshotFile file("TestRestoredChildCanBeReplacedWithHeapNode.snapshot", root);
+         auto restored = ReadSnapshot<TreeNode>(file.m_path);
+
+         restored->m_left.reset(new TreeNode(5));
+         restored->m_left.reset(new TreeNode(6));
+         Assert::AreEqual(6, restored->m_left->m_value);
+         Assert::AreEqual(3, restored->m_right->m_value);
+      }
+
+      TEST_METHOD(TestSnapshotOfEmptyTree)
+      {
+         SnapshotFile file("TestSnapshotOfEmptyTree.snapshot", SlabUniquePtr<TreeNode>());
+
+         Assert::IsNull(ReadSnapshot<TreeNode>(file.m_path).get());
+      }
+
+      TEST_METHOD(TestSnapshotRejectsNodeCountPastFile)
+      {
+         SlabUniquePtr<TreeNode> root(new TreeNode(1));
+         SnapshotFile file("TestSnapshotRejectsNodeCountPastFile.snapshot", root);
+         {
+            // A count that does not fit into a 32-bit size_t and one past the written node.
+            std::fstream stream(file.m_path, std::ios::binary | std::ios::in | std::ios::out);
+            SnapshotHeader header;
+            stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+            header.m_nodeCount = (1ull << 32) + 1;
+            stream.seekp(0);
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+         }
+         bool thrown = false;
+
+         try
+         {
+            ReadSnapshot<TreeNode>(file.m_path);
+         }
+         catch (const std::runtime_error&)
+         {
+            thrown = true;
+         }
+
+         Assert::IsTrue(thrown, L"Node count past the end of the file was not refused.");
+      }
+
+      TEST_METHOD(TestMakeBudgetedChargesAndRefunds)
+      {
+         Budget budget("test", 64, 64);
+
+         {
+            auto unique = MakeBudgeted<double>(budget, 4.2);
+
+            Assert::AreEqual(4.2, *unique);
+            Assert::AreEqual(sizeof(double), budget.used());
+         }
+
+         Assert::AreEqual(size_t(0), budget.used());
+      }
+
+      TEST_METHOD(TestBudgetedUniquePtrWithoutBudgetDeletesWithoutRefund)
+      {
+         Budget budget("test", 64, 64);
+         auto charged = MakeBudgeted<int>(budget);
+         bool destructorCalled = false;
+
+         {
+            UniquePtr<Dummy, BudgetedDeleter<Dummy>> unique;
+            unique.reset(new DummyWithDestructor(destructorCalled));
+         }
+
+         Assert::IsTrue(destructorCalled);
+         Assert::AreEqual(sizeof(int), budget.used());
+      }
+
+      TEST_METHOD(TestSoftLimitHandlerIsCalledOnCrossing)
+      {
+         int softLimitCalls = 0;
+         Budget budget("test", sizeof(int), 4 * sizeof(int), [&softLimitCalls](Budget&){ ++softLimitCalls; });
+
+         auto first = MakeBudgeted<int>(budget);
+         Assert::AreEqual(0, softLimitCalls);
+
+         auto second = MakeBudgeted<int>(budget);
+         auto third = MakeBudgeted<int>(budget);
+         Assert::AreEqual(1, softLimitCalls);
+      }
+
+      TEST_METHOD(TestHardLimitRefusesAllocation)
+      {
+         Budget budget("test", sizeof(int), sizeof(int));
+         auto first = MakeBudgeted<int>(budget);
+         bool thrown = false;
+
+         try
+         {
+            MakeBudgeted<int>(budget);
+         }
+         catch (const std::bad_alloc&)
+         {
+            thrown = true;
+         }
+
+         Assert::IsTrue(thrown, L"Allocation over the hard limit was not refused.");
+         Assert::AreEqual(sizeof(int), budget.used());
+      }
+
+      TEST_METHOD(TestHardLimitHandlerCanShedLoad)
+      {
+         BudgetedUniquePtr<int> cached;
+         Budget budget("test", sizeof(int), sizeof(int), nullptr, [&cached](Budget&){ cached.reset(); });
+         cached = MakeBudgeted<int>(budget);
+
+         auto unique = MakeBudgeted<int>(budget);
+
+         Assert::IsNull(cached.get());
+         Assert::AreEqual(sizeof(int), budget.used());
+      }
+
+      TEST_METHOD(TestConcurrentChargesUpToHardLimitSucceed)
+      {
+         const size_t threadsCount = 4;
+         const size_t chargesCount = 10000;
+         std::atomic<int> softLimitCalls(0);
+         Budget budget("test", chargesCount, threadsCount * chargesCount, [&softLimitCalls](Budget&){ ++softLimitCalls; });
+         std::atomic<size_t> refused(0);
+
+         std::vector<std::thread> threads;
+         for (size_t i = 0; i < threadsCount; ++i)
+         {
+            threads.emplace_back([&]()
+            {
+               for (size_t j = 0; j < chargesCount; ++j)
+               {
+                  if (!budget.charge(1))
+                  {
+                     ++refused;
+                  }
+               }
+            });
+         }
+         for (auto& thread : threads)
+         {
+            thread.join();
+         }
+
+         Assert::AreEqual(size_t(0), refused.load());
+         Assert::AreEqual(threadsCount * chargesCount, budget.used());
+         Assert::AreEqual(1, softLimitCalls.load());
+         Assert::IsFalse(budget.charge(1));
+
+         budget.refund(threadsCount * chargesCount);
+         Assert::AreEqual(size_t(0), budget.used());
+      }
+
+      TEST_METHOD(TestSpscChannelKeepsOrder)
+      {
+         SpscChannel<int> channel(4);
+         int* ptr1 = new int(1);
+         int* ptr2 = new int(2);
+
+         Assert::IsTrue(channel.push(UniquePtr<int>(ptr1)));
+         Assert::IsTrue(channel.push(UniquePtr<int>(ptr2)));
+
+         Assert::IsTrue(channel.tryPop().get() == ptr1);
+         Assert::IsTrue(channel.tryPop().get() == ptr2);
+         Assert::IsNull(channel.tryPop().get());
+      }
+
+      TEST_METHOD(TestChannelPushToFullChannelKeepsItem)
+      {
+         SpscChannel<int> channel(2);
+         MpscChannel<int> mpscChannel(2);
+         for (size_t i = 0; i < channel.capacity(); ++i)
+         {
+            channel.push(MakeUnique<int>());
+            mpscChannel.push(MakeUnique<int>());
+         }
+         auto unique = MakeUnique<int>();
+
+         Assert::IsFalse(channel.push(std::move(unique)));
+         Assert::IsFalse(mpscChannel.push(std::move(unique)));
+         Assert::IsNotNull(unique.get());
+      }
+
+      TEST_METHOD(TestChannelDestroysLeftoverItems)
+      {
+         {
+            SpscChannel<DestructorCallCounter> channel(4);
+            MpscChannel<DestructorCallCounter> mpscChannel(4);
+            channel.push(MakeUnique<DestructorCallCounter>());
+            mpscChannel.push(MakeUnique<DestructorCallCounter>());
+            mpscChannel.push(MakeUnique<DestructorCallCounter>());
+         }
+
+         Assert::AreEqual(3, DestructorCallCounter::m_destructorCallsCount);
+      }
+
+      TEST_METHOD(TestChannelBatches)
+      {
+         SpscChannel<int> channel(4);
+         MpscChannel<int> mpscChannel(4);
+         UniquePtr<int> items[6];
+         UniquePtr<int> mpscItems[6];
+         for (int i = 0; i < 6; ++i)
+         {
+            items[i].reset(new int(i));
+            mpscItems[i].reset(new int(i));
+         }
+
+         Assert::AreEqual(size_t(4), channel.pushBatch(items, 6));
+         Assert::AreEqual(size_t(4), mpscChannel.pushBatch(mpscItems, 6));
+         Assert::IsNotNull(items[4].get());
+         Assert::IsNotNull(mpscItems[4].get());
+
+         UniquePtr<int> popped[6];
+         Assert::AreEqual(size_t(4), channel.popBatch(popped, 6));
+         Assert::AreEqual(3, *popped[3]);
+         Assert::AreEqual(size_t(4), mpscChannel.popBatch(popped, 6));
+         Assert::AreEqual(3, *popped[3]);
+      }
+
+      TEST_METHOD(TestChannelRefusesCapacityPastSizeRange)
+      {
+         bool thrown = false;
+
+         try
+         {
+            SpscChannel<int> channel(static_cast<size_t>(-1));
+         }
+         catch (const std::length_error&)
+         {
+            thrown = true;
+         }
+
+         Assert::IsTrue(thrown, L"Capacity past the range of size_t was not refused.");
+      }
+
+      TEST_METHOD(TestMpscChannelBatchFillsAllFreeSlots)
+      {
+         MpscChannel<int> channel(8);
+         UniquePtr<int> items[6];
+         for (int i = 0; i < 6; ++i)
+         {
+            channel.push(MakeUnique<int>(i));
+            items[i].reset(new int(i));
+         }
+         channel.tryPop();
+         channel.tryPop();
+
+         Assert::AreEqual(size_t(4), channel.pushBatch(items, 6));
+         Assert::IsNull(items[3].get());
+         Assert::IsNotNull(items[4].get());
+      }
+
+      TEST_METHOD(TestMpscChannelWithConcurrentProducers)
+      {
+         const int producersCount = 4;
+         const int itemsPerProducer = 10000;
+         MpscChannel<int> channel(64);
+         std::vector<std::thread> producers;
+         for (int producer = 0; producer < producersCount; ++producer)
+         {
+            producers.emplace_back([&channel, producer, itemsPerProducer]()
+            {
+               for (int i = 0; i < itemsPerProducer; ++i)
+               {
+                  auto item = MakeUnique<int>(producer * itemsPerProducer + i);
+                  while (!channel.push(std::move(item)))
+                  {
+                     std::this_thread::yield();
+                  }
+               }
+            });
+         }
+
+         std::vector<int> lastSeen(producersCount, -1);
+         for (int received = 0; received < producersCount * itemsPerProducer;)
+         {
+            auto item = channel.tryPop();
+            if (!item)
+            {
+               std::this_thread::yield();
+               continue;
+            }
+
+            const int producer = *item / itemsPerProducer;
+            Assert::IsTrue(lastSeen[producer] < *item % itemsPerProducer, L"Items of a producer are out of order.");
+            lastSeen[producer] = *item % itemsPerProducer;
+            ++received;
+         }
+
+         for (auto& producer : producers)
+         {
+            producer.join();
+         }
+         Assert::IsNull(channel.tryPop().get());
+      }
+
+      TEST_METHOD(TestMakeUniquePromotable)
+      {
+         bool destructorCalled = false;
+
+         {
+            auto unique = MakeUniquePromotable<DummyWithDestructor>(destructorCalled);
+            Assert::AreEqual(sizeof(DummyWithDestructor*), sizeof(unique));
+         }
+
+         Assert::IsTrue(destructorCalled);
+      }
+
+      TEST_METHOD(TestPromoteKeepsObject)
+      {
+         auto unique = MakeUniquePromotable<int>(42);
+         int* ptr = unique.get();
+
+         SharedPtr<int> shared = Promote(std::move(unique));
+
+         Assert::IsNull(unique.get(), L"UniquePtr still holds pointer.");
+         Assert::IsTrue(shared.get() == ptr, L"Object was moved on promotion.");
+         Assert::AreEqual(42, *shared);
+         Assert::AreEqual(size_t(1), shared.use_count());
+         Assert::AreEqual(sizeof(int*), sizeof(shared));
+      }
+
+      TEST_METHOD(TestSharedPtrDestroysObjectWithLastOwner)
+      {
+         bool destructorCalled = false;
+         SharedPtr<DummyWithDestructor> shared = Promote(MakeUniquePromotable<DummyWithDestructor>(destructorCalled));
+         SharedPtr<DummyWithDestructor> copy = shared;
+
+         Assert::AreEqual(size_t(2), shared.use_count());
+         Assert::IsTrue(copy == shared);
+
+         shared = nullptr;
+         Assert::IsFalse(destructorCalled, L"Object was destroyed while still owned.");
+         Assert::AreEqual(size_t(1), copy.use_count());
+
+         SharedPtr<DummyWithDestructor> moved = std::move(copy);
+         Assert::IsTrue(copy == nullptr);
+
+         moved.reset();
+         Assert::IsTrue(destructorCalled, L"Destructor was not called.");
+      }
+
+      TEST_METHOD(TestIntrusivePtrDestroysObjectWithLastOwner)
+      {
+         using Counted = RefCountedDummy<PlainCountPolicy>;
+         bool destructorCalled = false;
+         IntrusivePtr<Counted, PlainCountPolicy> intrusive(new Counted(destructorCalled));
+         IntrusivePtr<Counted, PlainCountPolicy> copy = intrusive;
+         IntrusivePtr<Counted, PlainCountPolicy> fromRaw(intrusive.get());
+
+         Assert::AreEqual(size_t(3), intrusive.use_count());
+         Assert::IsTrue(copy == intrusive);
+         Assert::AreEqual(sizeof(Counted*), sizeof(intrusive));
+
+         intrusive = nullptr;
+         copy.reset();
+         Assert::IsFalse(destructorCalled, L"Object was destroyed while still owned.");
+
+         fromRaw.reset();
+         Assert::IsTrue(destructorCalled, L"Destructor was not called.");
+      }
+
+      TEST_METHOD(TestIntrusivePtrAdoptsUniquePtr)
+      {
+         using Counted = RefCountedDummy<AtomicCountPolicy>;
+         bool destructorCalled = false;
+         auto unique = MakeUnique<Counted>(destructorCalled);
+         Counted* ptr = unique.get();
+
+         {
+            IntrusivePtr<Counted> intrusive = std::move(unique);
+
+            Assert::IsNull(unique.get(), L"UniquePtr still holds pointer.");
+            Assert::IsTrue(intrusive.get() == ptr, L"Object was moved on adoption.");
+            Assert::AreEqual(size_t(1), intrusive.use_count());
+         }
+
+         Assert::IsTrue(destructorCalled);
+      }
+
+      TEST_METHOD(TestIntrusivePtrUsesCustomDeleter)
+      {
+         using Counted = RefCountedDummy<PlainCountPolicy>;
+         bool destructorCalled = false;
+         bool customDeleterCalled = false;
+         auto deleter = [&customDeleterCalled](Counted* i_ptr)
+         {
+            customDeleterCalled = true;
+            delete i_ptr;
+         };
+
+         {
+            IntrusivePtr<Counted, PlainCountPolicy, decltype(deleter)> intrusive(new Counted(destructorCalled), deleter);
+            auto copy = intrusive;
+         }
+
+         Assert::IsTrue(customDeleterCalled);
+         Assert::IsTrue(destructorCalled);
+      }
+
+#ifdef UNIQUE_PTR_CHECKED
+      TEST_METHOD(TestCheckedModeDetectsDoubleOwnership)
+      {
+         ViolationRecorder recorder;
+         auto unique = MakeUnique<int>();
+
+         UniquePtr<int> second(unique.get());
+         second.release();
+
+         Assert::AreEqual(1, ViolationRecorder::m_violationsCount);
+         Assert::IsTrue(ViolationRecorder::m_lastViolation.m_kind == OwnershipViolationKind::DoubleOwnership);
+         Assert::IsTrue(ViolationRecorder::m_lastViolation.m_pointer == unique.get());
+      }
+
+      TEST_METHOD(TestCheckedModeAllowsOwnershipTransfer)
+      {
+         ViolationRecorder recorder;
+         auto unique = MakeUnique<int>();
+
+         UniquePtr<int> moved = std::move(unique);
+         UniquePtr<int> adopted(moved.release());
+         unique = std::move(adopted);
+         unique.reset();
+
+         Assert::AreEqual(0, ViolationRecorder::m_violationsCount);
+      }
+
+      TEST_METHOD(TestCheckedModeTracksMovedObjects)
+      {
+         ViolationRecorder recorder;
+         auto unique = MakeUnique<int>();
+         UniquePtr<int> moved = std::move(unique);
+
+         UniquePtr<int> second(moved.get());
+         second.release();
+
+         Assert::AreEqual(1, ViolationRecorder::m_violationsCount);
+         Assert::IsTrue(ViolationRecorder::m_lastViolation.m_kind == OwnershipViolationKind::DoubleOwnership);
+      }
+
+      TEST_METHOD(TestCheckedModeTracksObjectsPassedThroughChannels)
+      {
+         ViolationRecorder recorder;
+         SpscChannel<int> channel(2);
+         channel.push(MakeUnique<int>());
+         auto unique = channel.tryPop();
+
+         UniquePtr<int> second(unique.get());
+         second.release();
+
+         Assert::AreEqual(1, ViolationRecorder::m_violationsCount);
+         Assert::IsTrue(ViolationRecorder::m_lastViolation.m_kind == OwnershipViolationKind::DoubleOwnership);
+      }
+
+      TEST_METHOD(TestCheckedModeTracksConvertedObjects)
+      {
+         ViolationRecorder recorder;
+         const size_t sampledBefore = OwnershipChecker::sampledAllocations();
+
+         {
+            UniquePtr<SecondBase> converted = MakeUnique<DerivedFromBoth>();
+            Assert::IsTrue(static_cast<void*>(converted.get()) != static_cast<void*>(static_cast<DerivedFromBoth*>(converted.get())));
+
+            UniquePtr<SecondBase> second(converted.get());
+            second.release();
+            Assert::AreEqual(1, ViolationRecorder::m_violationsCount);
+            Assert::IsTrue(ViolationRecorder::m_lastViolation.m_pointer == converted.get());
+         }
+
+         Assert::AreEqual(sampledBefore, OwnershipChecker::sampledAllocations());
+      }
+
+      TEST_METHOD(TestCheckedModeDetectsMismatchedDeleter)
+      {
+         ViolationRecorder recorder;
+
+         {
+            UniquePtr<MismatchTolerant, DefaultDeleter<MismatchTolerant[]>> mismatched = MakeUnique<MismatchTolerant>();
+         }
+
+         Assert::AreEqual(1, ViolationRecorder::m_violationsCount);
+         Assert::IsTrue(ViolationRecorder::m_lastViolation.m_kind == OwnershipViolationKind::MismatchedDeleter);
+         Assert::IsFalse(ViolationRecorder::m_lastViolation.m_allocatedAsArray);
+      }
+
+      TEST_METHOD(TestCheckedModeForgetsReleasedObjects)
+      {
+         ViolationRecorder recorder;
+         const size_t sampledBefore = OwnershipChecker::sampledAllocations();
+
+         // Released arrays are freed outside UniquePtr, their addresses are then reused by
+         // objects that MakeUnique did not allocate.
+         for (int i = 0; i < 100; ++i)
+         {
+            delete[] MakeUnique<int[]>(1).release();
+            UniquePtr<int>(new int);
+         }
+
+         Assert::AreEqual(sampledBefore, OwnershipChecker::sampledAllocations());
+         Assert::AreEqual(0, ViolationRecorder::m_violationsCount);
+      }
+
+      TEST_METHOD(TestCheckedModeForgetsDestroyedObjects)
+      {
+         ViolationRecorder recorder;
+         const size_t sampledBefore = OwnershipChecker::sampledAllocations();
+
+         {
+            auto unique = MakeUnique<int>();
+            auto array = MakeUnique<int[]>(2);
+            Assert::AreEqual(sampledBefore + 2, OwnershipChecker::sampledAllocations());
+         }
+
+         Assert::AreEqual(sampledBefore, OwnershipChecker::sampledAllocations());
+         Assert::AreEqual(0, ViolationRecorder::m_violationsCount);
+      }
+#endif
    };
 }
\ No newline at end of file